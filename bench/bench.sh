@@ -0,0 +1,251 @@
+#!/bin/sh
+#
+# Benchmarks for the Xdialog streaming boxes (make bench in src/, which also
+# runs textbench for the text functions).
+#
+#   bench.sh [Xdialog] [scenario...]
+#
+# Each scenario feeds a box with synthetic data in batches, at a given rate
+# (per second, 0 for as fast as possible), the generator logging the time of
+# each write and Xdialog recording its updates into a trace file (see
+# XDIALOG_TRACE in src/support.c).  One JSON object per scenario is then
+# written on stdout, with:
+#   count       values, lines or bytes read by the box,
+#   throughput  count per second, from the first write to the last paint,
+#   latency     write-to-paint percentiles (ms), from the write of a batch to
+#               the first paint once the box has read all of it,
+#   utime/stime CPU time (ms) and maxrss peak resident set size (KiB).
+#
+# The scenarios are gauge, gauge-rate, logbox, logbox-rate, tailbox and
+# tailbox-rate (all by default).  Without a DISPLAY, an Xvfb server or, for
+# GTK+ 3, a GDK broadway server is started for the time of the benchmarks.
+# BENCH_COUNT scales the amounts of data (1 by default).  The write times are
+# taken with "date +%s%N" (GNU date).
+#
+
+XDIALOG=${1:-./Xdialog}
+[ $# -gt 0 ] && shift
+SCENARIOS=${*:-"gauge gauge-rate logbox logbox-rate tailbox tailbox-rate"}
+SCALE=${BENCH_COUNT:-1}
+
+if [ ! -x "$XDIALOG" ] ; then
+	echo "bench.sh: $XDIALOG: no such program" >&2
+	exit 1
+fi
+case $(date +%N) in
+	*[!0-9]*|"")
+		echo "bench.sh: date +%N is not supported (GNU date needed)" >&2
+		exit 1 ;;
+esac
+
+TMP=$(mktemp -d /tmp/xdialog-bench.XXXXXX) || exit 1
+SERVER=""
+cleanup() {
+	[ -n "$SERVER" ] && kill $SERVER 2>/dev/null
+	rm -rf "$TMP"
+}
+trap cleanup EXIT
+trap 'exit 1' INT TERM
+
+# ------------------------------------------------------------------------
+# virtual display
+
+if [ -z "$DISPLAY" ] && [ -z "$BROADWAY_DISPLAY" ] ; then
+	if command -v Xvfb >/dev/null 2>&1 ; then
+		for n in 99 98 97 96 95 ; do
+			[ -e /tmp/.X$n-lock ] && continue
+			Xvfb :$n -screen 0 1280x1024x24 -nolisten tcp >/dev/null 2>&1 &
+			SERVER=$!
+			DISPLAY=:$n
+			break
+		done
+	elif command -v broadwayd >/dev/null 2>&1 ; then
+		broadwayd :5 >/dev/null 2>&1 &
+		SERVER=$!
+		GDK_BACKEND=broadway
+		BROADWAY_DISPLAY=:5
+		export GDK_BACKEND BROADWAY_DISPLAY
+	else
+		echo "bench.sh: no DISPLAY, and neither Xvfb nor broadwayd found" >&2
+		exit 1
+	fi
+	export DISPLAY
+	sleep 1
+fi
+
+# ------------------------------------------------------------------------
+# synthetic data generators: "<first> <n>" units, written on stdout
+
+# Current time (us)
+now_us() {
+	t=$(date +%s%N)
+	echo ${t%???}
+}
+
+# Writes the output of "$1 <first> <n>" in batches, <rate> per second (100
+# batches at full speed), logging "<units written> <time (us)>" before each
+# batch into $TMP/writes
+paced() {
+	gen=$1 count=$2 rate=$3
+	: >"$TMP/writes"
+	if [ "$rate" -eq 0 ] ; then
+		batch=$(( count / 100 ))
+	else
+		batch=$(( rate / 20 ))
+	fi
+	[ $batch -lt 1 ] && batch=1
+	i=0
+	while [ $i -lt $count ] ; do
+		n=$batch
+		[ $(( i + n )) -gt $count ] && n=$(( count - i ))
+		echo $(( i + n )) $(now_us) >>"$TMP/writes"
+		$gen $i $n
+		i=$(( i + n ))
+		[ "$rate" -ne 0 ] && sleep $(awk "BEGIN { print $n / $rate }")
+	done
+}
+
+gauge_values() {
+	awk -v first=$1 -v n=$2 'BEGIN { for (i = first; i < first + n; i++) print i % 101 }'
+}
+
+# Log lines, one in four with ANSI colours
+log_lines() {
+	awk -v first=$1 -v n=$2 'BEGIN {
+		for (i = first; i < first + n; i++)
+			if (i % 4 == 0)
+				printf "\033[1;3%d;4%dmline %d: coloured text\n", i % 8, (i + 4) % 8, i
+			else
+				printf "line %d: some plain text for the log box\n", i
+	}'
+}
+
+# 60 bytes lines
+tail_bytes() {
+	awk -v first=$1 -v n=$2 'BEGIN {
+		for (i = first; i < first + n; i++)
+			printf "%015d the quick brown fox jumps over the lazy dog\n", i
+	}'
+}
+
+# ------------------------------------------------------------------------
+# scenarios
+
+# Runs Xdialog with the trace file $TMP/trace, stdin from the generator
+run_piped() {
+	rate=$1 count=$2 gen=$3
+	shift 3
+	paced $gen $count $rate | XDIALOG_TRACE=$TMP/trace "$XDIALOG" "$@" 2>/dev/null
+}
+
+# Same, the generator appending to the $TMP/data file read by the box, which
+# is then closed through a control channel once it has caught up
+run_file() {
+	rate=$1 count=$2 gen=$3
+	shift 3
+	: >"$TMP/data"
+	rm -f "$TMP/control"
+	mkfifo "$TMP/control" || exit 1
+	XDIALOG_TRACE=$TMP/trace "$XDIALOG" --control-fd 3 "$@" \
+		3<"$TMP/control" 2>/dev/null &
+	pid=$!
+	exec 4>"$TMP/control"
+	sleep 1
+	paced $gen $count $rate >>"$TMP/data"
+	sleep 1
+	echo close >&4
+	exec 4>&-
+	wait $pid
+}
+
+# Turns the write times and the trace into the JSON results of a scenario,
+# the trace counts being <unit> per generated unit
+report() {
+	awk -v name="$1" -v rate="$2" -v unit="$3" '
+	function field(key,    s) {
+		if (!match($0, "\"" key "\": [0-9]+"))
+			return ""
+		s = substr($0, RSTART, RLENGTH)
+		sub(/.*: /, "", s)
+		return s + 0
+	}
+	function pct(p,    i) {
+		if (n == 0)
+			return "null"
+		i = int(p * n / 100 + 0.999999)
+		return sprintf("%.3f", lat[i < 1 ? 1 : i] / 1000)
+	}
+	# the write times, in the wall clock
+	FILENAME == ARGV[1] {
+		written[++writes] = $1 * unit
+		wtime[writes] = $2
+		next
+	}
+	# the trace clock (ts) matching the wall clock
+	/"name": "clock"/ {
+		offset = field("real") - field("ts")
+	}
+	/"name": "input"/ {
+		count += field("count")
+	}
+	# the batches read in full are shown by this paint
+	/"name": "paint"/ {
+		ts = field("ts")
+		paints++
+		while (done < writes && written[done + 1] <= count) {
+			done++
+			lat[++n] = ts - (wtime[done] - offset)
+			last = ts
+		}
+	}
+	/"name": "rusage"/ {
+		utime = field("utime"); stime = field("stime"); maxrss = field("maxrss")
+	}
+	END {
+		# insertion sort of the latencies
+		for (i = 2; i <= n; i++) {
+			v = lat[i]
+			for (j = i - 1; j > 0 && lat[j] > v; j--)
+				lat[j + 1] = lat[j]
+			lat[j + 1] = v
+		}
+		printf "{\"scenario\": \"%s\", \"rate\": %d, \"count\": %d, ", name, rate, count
+		first = (writes > 0) ? wtime[1] - offset : 0
+		printf "\"throughput\": %s, ", (n > 0 && last > first) ? sprintf("%.1f", count * 1000000 / (last - first)) : "null"
+		printf "\"paints\": %d, \"latency\": {\"p50\": %s, \"p90\": %s, \"p99\": %s, \"max\": %s}, ",
+		       paints, pct(50), pct(90), pct(99), pct(100)
+		printf "\"utime\": %s, \"stime\": %s, \"maxrss\": %s}\n",
+		       utime == "" ? "null" : sprintf("%.1f", utime / 1000),
+		       stime == "" ? "null" : sprintf("%.1f", stime / 1000),
+		       maxrss == "" ? "null" : maxrss
+	}' "$TMP/writes" "$TMP/trace"
+}
+
+for scenario in $SCENARIOS ; do
+	rm -f "$TMP/trace"
+	unit=1
+	case $scenario in
+		gauge)
+			rate=0 ; run_piped $rate $(( 2000 * SCALE )) gauge_values \
+				--gauge "Benchmark" 8 40 ;;
+		gauge-rate)
+			rate=50 ; run_piped $rate $(( 500 * SCALE )) gauge_values \
+				--gauge "Benchmark" 8 40 ;;
+		logbox)
+			rate=0 ; run_file $rate $(( 20000 * SCALE )) log_lines \
+				--logbox "$TMP/data" 20 70 ;;
+		logbox-rate)
+			rate=500 ; run_file $rate $(( 2500 * SCALE )) log_lines \
+				--time-stamp --logbox "$TMP/data" 20 70 ;;
+		tailbox)
+			rate=0 ; unit=60 ; run_file $rate $(( 50000 * SCALE )) tail_bytes \
+				--tailbox "$TMP/data" 20 70 ;;
+		tailbox-rate)
+			rate=2000 ; unit=60 ; run_file $rate $(( 10000 * SCALE )) tail_bytes \
+				--tailbox "$TMP/data" 20 70 ;;
+		*)
+			echo "bench.sh: unknown scenario: $scenario" >&2
+			exit 1 ;;
+	esac
+	[ -s "$TMP/trace" ] && report $scenario $rate $unit
+done
@@ -0,0 +1,208 @@
+/*
+ * Benchmark of the Xdialog text processing functions (src/text.c).
+ *
+ *   textbench [min_time_ms]
+ *
+ * Each function is run on inputs from 16 bytes to 1 MB (lines of 1 to 255
+ * bytes for the line reader used by my_scanf()), for at least min_time_ms (50 by
+ * default) per size, and one JSON object per function and size is written
+ * on stdout, with the time per input byte:
+ *
+ *   {"function": "remove_vt_sequences", "size": 1024, "ns_per_byte": 1.234}
+ *
+ * A linear function gives about the same ns_per_byte for all sizes, while it
+ * grows with the size when its running time is quadratic.  The in place
+ * functions work on a fresh copy of their input at each run, the copy being
+ * included in the time.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "text.h"
+
+#define MIN_SIZE   16
+#define MAX_SIZE   (1024 * 1024)
+#define WRAP_WIDTH 80
+#define LINE_SIZE  256    /* my_scanf() buffer */
+
+static const char *words[] = {
+    "lorem", "ipsum", "dolor", "sit", "amet,", "consectetur", "adipiscing",
+    "elit,", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore"
+};
+#define NWORDS (sizeof(words) / sizeof(words[0]))
+
+static char *input, *copy, *output;
+static size_t size;
+static volatile size_t sink;    /* results, for the calls not to be dropped */
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Fills "input" with "size" bytes of words, separated with "sep" and with
+ * "insert" every "every" bytes (if not NULL).
+ */
+static void make_text(const char *sep, const char *insert, size_t every)
+{
+    size_t n = 0, next = every, len;
+    unsigned i = 0;
+    const char *s;
+
+    while (n < size) {
+        if (insert != NULL && n >= next) {
+            s = insert;
+            next += every;
+        } else {
+            s = words[i++ % NWORDS];
+        }
+        len = strlen(s);
+        if (n + len > size)
+            len = size - n;
+        memcpy(input + n, s, len);
+        n += len;
+        len = strlen(sep);
+        if (n + len > size)
+            len = size - n;
+        memcpy(input + n, sep, len);
+        n += len;
+    }
+    input[size] = '\0';
+}
+
+/* Fills "input" with "size" bytes of lines of 1 to LINE_SIZE - 1 bytes (the
+ * linefeed included), their lengths spread over the whole range.
+ */
+static void make_lines(void)
+{
+    size_t n = 0, len;
+    unsigned i = 0;
+
+    while (n < size) {
+        len = 1 + (i++ * 97) % (LINE_SIZE - 1);
+        if (n + len > size)
+            len = size - n;
+        memset(input + n, 'a' + i % 26, len - 1);
+        input[n + len - 1] = '\n';
+        n += len;
+    }
+    input[size] = '\0';
+}
+
+static void run_backslash_n(void)
+{
+    sink += normalize_text(input, output, size + 1, 0);
+}
+
+static void run_trim(void)
+{
+    sink += normalize_text(input, output, size + 1, NORMALIZE_TRIM);
+}
+
+static void run_trim_cr_wrap(void)
+{
+    sink += normalize_text(input, output, size + 1,
+                           NORMALIZE_TRIM | NORMALIZE_CR_WRAP);
+}
+
+static void run_remove_vt(void)
+{
+    memcpy(copy, input, size + 1);
+    sink += remove_vt_sequences(copy);
+}
+
+static int fixed_width(unsigned char c, void *data)
+{
+    (void) c;
+    (void) data;
+    return 1;
+}
+
+static void run_wrap(void)
+{
+    memcpy(copy, input, size + 1);
+    wrap_words(copy, WRAP_WIDTH, fixed_width, NULL);
+    sink += copy[size / 2];
+}
+
+/* The input is fed to a line buffer in chunks, as read() would, and all its
+ * lines are taken with a my_scanf() sized buffer.
+ */
+static void run_lines(void)
+{
+    static line_buffer buffer;
+    char line[LINE_SIZE], *space;
+    size_t n, chunk, fed = 0;
+
+    line_buffer_reset(&buffer);
+    while (fed < size) {
+        space = line_buffer_space(&buffer, &chunk);
+        n = size - fed < chunk ? size - fed : chunk;
+        memcpy(space, input + fed, n);
+        line_buffer_fill(&buffer, n);
+        fed += n;
+        while (line_buffer_next(&buffer, line, sizeof(line)))
+            sink += line[0];
+    }
+}
+
+static void bench(const char *name, void (*run)(void), double min_ns)
+{
+    double start, elapsed;
+    long runs = 0;
+
+    start = now_ns();
+    do {
+        run();
+        runs++;
+        elapsed = now_ns() - start;
+    } while (elapsed < min_ns);
+
+    printf("{\"function\": \"%s\", \"size\": %lu, \"ns_per_byte\": %.3f}\n",
+           name, (unsigned long) size, elapsed / runs / size);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    double min_ns = (argc > 1 ? atof(argv[1]) : 50) * 1e6;
+
+    input  = malloc(MAX_SIZE + 1);
+    copy   = malloc(MAX_SIZE + 1);
+    output = malloc(MAX_SIZE + 1);
+    if (input == NULL || copy == NULL || output == NULL) {
+        fprintf(stderr, "textbench: out of memory\n");
+        return 1;
+    }
+
+    for (size = MIN_SIZE; size <= MAX_SIZE; size *= 4) {
+        /* labels: "\n" every 60 bytes, tabs and doubled spaces */
+        make_text(" \t ", "\\n", 60);
+        bench("backslash_n_to_linefeed", run_backslash_n, min_ns);
+        bench("trim_string", run_trim, min_ns);
+        make_text("  ", NULL, 0);
+        bench("trim_string(spaces)", run_trim, min_ns);
+        make_text(" \n", NULL, 0);
+        bench("trim_string(cr_wrap)", run_trim_cr_wrap, min_ns);
+
+        /* log lines: a colour sequence every 32 bytes */
+        make_text(" ", "\033[1;31;46m", 32);
+        bench("remove_vt_sequences", run_remove_vt, min_ns);
+
+        make_text(" ", NULL, 0);
+        bench("wrap_words", run_wrap, min_ns);
+
+        /* lines of all the lengths my_scanf() takes */
+        make_lines();
+        bench("line_buffer", run_lines, min_ns);
+    }
+    return 0;
+}
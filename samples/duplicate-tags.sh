@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Items sharing a tag: the last one is the one found, by --default-item and
+# by the --control-fd commands (as with dialog).
+#
+
+. ./0common.sh || exit 1
+
+failed=0
+
+# expected result, control commands: the first "a" item is on, the last off
+check()
+{
+    expected=$1
+    shift
+    result=`printf '%s\n' "$@" "click ok" | \
+            $DIALOG --stdout --control-fd 0 --checklist "Duplicate tags" 0 0 0 \
+                    "a" "first" on \
+                    "a" "last"  off \
+                    "b" "other" off`
+    if [ "$result" = "$expected" ] ; then
+        echo "ok: $* -> '$result'"
+    else
+        echo "FAILED: $* -> '$result' (expected '$expected')"
+        failed=1
+    fi
+}
+
+check "a" "remove a"                # the last "a" item goes
+check ""  "remove a" "remove a"     # then the first one
+check "a" "state a off"             # the last one is already off
+check "a/b" "state b on"
+
+# --default-item: the cursor must be on the "last" row
+$DIALOG --stdout --default-item "a" \
+        --menu "The \"last\" item must be selected." 0 0 0 \
+        "a" "first" \
+        "b" "other" \
+        "a" "last"
+echo
+
+exit $failed
@@ -5,12 +5,22 @@
 #include "common.h"
 
 #include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 
 #include "callbacks.h"
 #include "interface.h"
 #include "support.h"
 
 extern Xdialog_data Xdialog;
+extern gboolean reuse_window;
+
+#if GTK_CHECK_VERSION(2,0,0)
+static void print_flush(void);
+#endif
 
 /* This function is called when a "delete_event" is received from the window
  * manager. It is used to trigger a "destroy" event by returning FALSE
@@ -26,6 +36,9 @@ gboolean delete_event(gpointer object, GdkEventAny *event, gpointer data)
  */
 gboolean destroy_event(gpointer object, GdkEventAny *event, gpointer data)
 {
+#if GTK_CHECK_VERSION(2,0,0)
+    print_flush();
+#endif
     if (Xdialog.timer != 0) {
         g_source_remove(Xdialog.timer);
         Xdialog.timer = 0;
@@ -34,18 +47,32 @@ gboolean destroy_event(gpointer object, GdkEventAny *event, gpointer data)
         g_source_remove(Xdialog.timer2);
         Xdialog.timer2 = 0;
     }
-    gtk_main_quit();
+    stats_free();
+    watchdog_stop();
+    logbox_stop();
+    if (gtk_main_level() > 0)
+        gtk_main_quit();
     Xdialog.window = Xdialog.widget1 = Xdialog.widget2 = Xdialog.widget3 = NULL;
+    Xdialog.print_file = NULL;
+
+    if (Xdialog.label_text != NULL) {
+        g_string_free(Xdialog.label_text, TRUE);
+        Xdialog.label_text = NULL;
+    }
 
     if (Xdialog.file != NULL) {
         if (Xdialog.file != stdin)
             fclose(Xdialog.file);
         Xdialog.file = NULL;
     }
-    if (Xdialog.array != NULL) {
-        g_free(Xdialog.array);
-        Xdialog.array = NULL;
-    }
+    free_list();
+#if GTK_CHECK_VERSION(2,0,0)
+    list_filter_free();
+#endif
+#if GTK_CHECK_VERSION(2,4,0)
+    combo_index_free();
+#endif
+    report_changes_free();
 
     if (Xdialog.beep & BEEP_AFTER && Xdialog.exit_code != 2) {
         gdk_beep();
@@ -53,6 +80,53 @@ gboolean destroy_event(gpointer object, GdkEventAny *event, gpointer data)
     return FALSE;
 }
 
+/* The top level window kept for the next dialog in --script mode */
+static GtkWidget *spare_window = NULL;
+
+/* Closes the current dialog by destroying its top level window.  In --script
+ * mode, the windows set up by open_window() are kept for the next dialog: only
+ * their contents are destroyed and the "destroy" cleanup is done by hand.
+ */
+void close_window(void)
+{
+    GtkWidget *window = Xdialog.window;
+
+#if GTK_CHECK_VERSION(2,0,0)
+    if (reuse_window && window != NULL && Xdialog.vbox != NULL &&
+        g_object_get_data(G_OBJECT(window), "reusable") != NULL) {
+        g_signal_handlers_disconnect_by_func(G_OBJECT(window),
+                                             G_CALLBACK(exit_keypress), NULL);
+        gtk_widget_destroy(GTK_WIDGET(Xdialog.vbox));
+        Xdialog.vbox = NULL;
+        destroy_event(NULL, NULL, NULL);
+        spare_window = window;
+        return;
+    }
+#endif
+    gtk_widget_destroy(window);
+}
+
+GtkWidget *take_spare_window(void)
+{
+    GtkWidget *window = spare_window;
+
+    spare_window = NULL;
+    return window;
+}
+
+/* Destroys the kept window when the next dialog did not reuse it */
+void drop_spare_window(void)
+{
+    if (spare_window == NULL)
+        return;
+#if GTK_CHECK_VERSION(2,0,0)
+    g_signal_handlers_disconnect_by_func(G_OBJECT(spare_window),
+                                         G_CALLBACK(destroy_event), NULL);
+#endif
+    gtk_widget_destroy(spare_window);
+    spare_window = NULL;
+}
+
 /* Double-click event is processed as a button click in radiolist and
  * checklist... The button widget is to be passed as "data".
  */
@@ -76,12 +150,9 @@ gint double_click_event (GtkWidget *object, GdkEventButton *event, gpointer data
 gboolean exit_ok(gpointer object, gpointer data)
 {
     if (Xdialog.check) {
-        if (Xdialog.checked)
-            fprintf(Xdialog.output, "checked\n");
-        else
-            fprintf(Xdialog.output, "unchecked\n");
+        result_print(Xdialog.checked ? "checked" : "unchecked");
     }
-    gtk_widget_destroy(Xdialog.window);
+    close_window();
     Xdialog.exit_code = 0;
     return FALSE;
 }
@@ -89,12 +160,9 @@ gboolean exit_ok(gpointer object, gpointer data)
 gboolean exit_extra(gpointer object, gpointer data)
 {
     if (Xdialog.check) {
-        if (Xdialog.checked)
-            fprintf(Xdialog.output, "checked\n");
-        else
-            fprintf(Xdialog.output, "unchecked\n");
+        result_print(Xdialog.checked ? "checked" : "unchecked");
     }
-    gtk_widget_destroy(Xdialog.window);
+    close_window();
     Xdialog.exit_code = 3;
     return FALSE;
 }
@@ -102,7 +170,7 @@ gboolean exit_extra(gpointer object, gpointer data)
 gboolean exit_cancel(gpointer object, gpointer data)
 {
     Xdialog.exit_code = 1;
-    gtk_widget_destroy(Xdialog.window);
+    close_window();
     return FALSE;
 }
 
@@ -117,14 +185,14 @@ gint exit_keypress(gpointer object, GdkEventKey *event, gpointer data)
 gboolean exit_help(gpointer object, gpointer data)
 {
     Xdialog.exit_code = 2;
-    gtk_widget_destroy(Xdialog.window);
+    close_window();
     return FALSE;
 }
 
 gboolean exit_previous(gpointer object, gpointer data)
 {
     Xdialog.exit_code = 3;
-    gtk_widget_destroy(Xdialog.window);
+    close_window();
     return FALSE;
 }
 
@@ -137,7 +205,7 @@ gboolean checked(GtkWidget *button, gpointer data)
 gboolean timeout_exit(gpointer data)
 {
     Xdialog.exit_code = 255;
-    gtk_widget_destroy(Xdialog.window);
+    close_window();
     return FALSE;
 }
 
@@ -189,21 +257,19 @@ gboolean infobox_timeout(gpointer data)
          * start or the end of the label. */
         if (Xdialog.new_label) {
             gtk_label_set_text(GTK_LABEL(Xdialog.widget1),
-                       Xdialog.label_text);
-            Xdialog.label_text[0] = 0 ;
+                       Xdialog.label_text->str);
+            g_string_truncate(Xdialog.label_text, 0);
             Xdialog.new_label = FALSE;
         } else {
             Xdialog.new_label = TRUE;
         }
     } else {
         /* Add this text to the new label text */
-        if (strlen(Xdialog.label_text)+strlen(temp)+2 < MAX_LABEL_LENGTH) {
-            if (strcmp(temp, "\\n") == 0) {
-                strcat(Xdialog.label_text, "\n");
-            } else {
-                strcat(Xdialog.label_text, " ");
-                strcat(Xdialog.label_text, temp);
-            }
+        if (strcmp(temp, "\\n") == 0) {
+            g_string_append_c(Xdialog.label_text, '\n');
+        } else {
+            g_string_append_c(Xdialog.label_text, ' ');
+            g_string_append(Xdialog.label_text, temp);
         }
     }
 
@@ -259,6 +325,8 @@ gboolean gauge_timeout(gpointer data)
         /* Set the new value */
         gtk_progress_set_value (GTK_PROGRESS(Xdialog.widget1), new_val);
 #endif
+        trace_input(1);
+        stats_input(strlen(temp) + 1, 1);
     }
     else
     {
@@ -267,21 +335,19 @@ gboolean gauge_timeout(gpointer data)
              * start or the end of the label. */
             if (Xdialog.new_label) {
                 gtk_label_set_text(GTK_LABEL(Xdialog.widget2),
-                           Xdialog.label_text);
-                Xdialog.label_text[0] = 0 ;
+                           Xdialog.label_text->str);
+                g_string_truncate(Xdialog.label_text, 0);
                 Xdialog.new_label = FALSE;
             } else {
                 Xdialog.new_label = TRUE;
             }
         } else {
             /* Add this text to the new label text */
-            if (strlen(Xdialog.label_text)+strlen(temp)+2 < MAX_LABEL_LENGTH) {
-                if (strcmp(temp, "\\n") == 0) {
-                    strcat(Xdialog.label_text, "\n");
-                } else {
-                    strcat(Xdialog.label_text, " ");
-                    strcat(Xdialog.label_text, temp);
-                }
+            if (strcmp(temp, "\\n") == 0) {
+                g_string_append_c(Xdialog.label_text, '\n');
+            } else {
+                g_string_append_c(Xdialog.label_text, ' ');
+                g_string_append(Xdialog.label_text, temp);
             }
         }
     }
@@ -395,6 +461,8 @@ gboolean tailbox_timeout(gpointer data)
 
         gtk_text_buffer_get_end_iter(text_buffer, &end_iter);
         gtk_text_buffer_insert(text_buffer, &end_iter, buffer, nchars);
+        trace_input(nchars);
+        stats_input_text(buffer, nchars);
 
         if (Xdialog.file_init_size > 0) 
             Xdialog.file_init_size -= nchars;
@@ -439,6 +507,8 @@ gboolean tailbox_timeout(gpointer data)
 
         gtk_text_insert (GTK_TEXT(Xdialog.widget1), NULL, NULL,
                          NULL, buffer, nchars);
+        trace_input(nchars);
+        stats_input_text(buffer, nchars);
 
         if ((!Xdialog.smooth || flag) && Xdialog.file_init_size <= 0) {
             gtk_text_thaw (GTK_TEXT(Xdialog.widget1));
@@ -472,135 +542,49 @@ gint tailbox_keypress(GtkWidget *text, GdkEventKey *event,
 //                           logbox callbacks
 // ------------------------------------------------------------------------------------------
 
-static void vt_to_gdk_color(gint color, GdkColor **fgcolor, GdkColor **bgcolor)
-{
-    static const GdkColor BLACK     = { 0, 0x0000, 0x0000, 0x0000 };
-    static const GdkColor RED       = { 0, 0xffff, 0x0000, 0x0000 };
-    static const GdkColor GREEN     = { 0, 0x0000, 0xffff, 0x0000 };
-    static const GdkColor BLUE      = { 0, 0x0000, 0x0000, 0xffff };
-    static const GdkColor MAGENTA   = { 0, 0xffff, 0x0000, 0xffff };
-    static const GdkColor YELLOW    = { 0, 0xffff, 0xffff, 0x0000 };
-    static const GdkColor CYAN      = { 0, 0x0000, 0xffff, 0xffff };
-    static const GdkColor WHITE     = { 0, 0xffff, 0xffff, 0xffff };
-    switch (color)
-    {
-        case 30: *fgcolor = (GdkColor *) &BLACK;  break;
-        case 31: *fgcolor = (GdkColor *) &RED;    break;
-        case 32: *fgcolor = (GdkColor *) &GREEN;  break;
-        case 33: *fgcolor = (GdkColor *) &YELLOW; break;
-        case 34: *fgcolor = (GdkColor *) &BLUE;   break;
-        case 35: *fgcolor = (GdkColor *) &MAGENTA; break;
-        case 36: *fgcolor = (GdkColor *) &CYAN;  break;
-        case 37: *fgcolor = (GdkColor *) &WHITE; break;
-        case 38: *fgcolor = NULL; break;
-        //--
-        case 40: *bgcolor = (GdkColor *) &BLACK; break;
-        case 41: *bgcolor = (GdkColor *) &RED;   break;
-        case 42: *bgcolor = (GdkColor *) &GREEN; break;
-        case 43: *bgcolor = (GdkColor *) &YELLOW; break;
-        case 44: *bgcolor = (GdkColor *) &BLUE;   break;
-        case 45: *bgcolor = (GdkColor *) &MAGENTA;break;
-        case 46: *bgcolor = (GdkColor *) &CYAN;  break;
-        case 47: *bgcolor = (GdkColor *) &WHITE; break;
-        case 48: *bgcolor = NULL; break;
-    }
-}
-
-static void remove_vt_sequences(char *str)
-{
-    char *p, *q;
-    while ((p = strstr(str, "\033[")) != NULL) {
-        q = p;
-        while (++p < str + strlen(str)) {
-            if (*p == 'm')
-                break;
-        }
-        strcpy(q, ++p);
-    }
-}
-
+/* The rows are read and parsed by a reader thread (see logbox.c): they are
+ * inserted for LOGBOX_FRAME ms at most between two redraws, or all at once
+ * while the content of the file is loaded.
+ */
+#define LOGBOX_FRAME 8
 
 gboolean logbox_timeout(gpointer data)
 {
-    static GdkColor *old_fgcolor = NULL;
-    static GdkColor *old_bgcolor = NULL;
 #if GTK_CHECK_VERSION(2,0,0)
     GtkTreeView  * tree  = GTK_TREE_VIEW (Xdialog.widget1);
-    GtkTreeModel * model = gtk_tree_view_get_model (tree);
-    GtkListStore * store = GTK_LIST_STORE (model);
-    GtkTreeIter iter;
+    GtkListStore * store = GTK_LIST_STORE (gtk_tree_view_get_model (tree));
 #else // -- GTK1 --
     GtkCList *clist = GTK_CLIST(Xdialog.widget1);
     // the list may contain up to 2 rows
     static gchar *null_row[] = { NULL, NULL };
     int rownum;
 #endif
-
-    GdkColor *fgcolor, *bgcolor;
-    gchar buffer[MAX_LABEL_LENGTH], *p;
-    int color, len;
-    struct tm *localdate = NULL;
-    time_t curr_time;
+    logbox_row row;
+#if GLIB_CHECK_VERSION(2,32,0)
+    gint64 end = g_get_monotonic_time() + LOGBOX_FRAME * 1000;
+#endif
 
     if (Xdialog.file_init_size <= 0)
         if (!empty_gtk_queue())
             return FALSE;
 
-    while (fgets(buffer, MAX_LABEL_LENGTH, Xdialog.file) != NULL)
+    while (logbox_next(&row))
     {
-        len = strlen(buffer);
+        stats_input(row.length, row.text != NULL);
 
         if (Xdialog.file_init_size > 0) {
-            Xdialog.file_init_size -= len;
-        }
-        if ((len > 0) && (buffer[len - 1] == '\n')) {
-            buffer[--len] = 0;
-        }
-        if (Xdialog.time_stamp) {
-            time(&curr_time);
-            localdate = localtime(&curr_time);
-        }
-        if (Xdialog.keep_colors) {
-            fgcolor = old_fgcolor;
-            bgcolor = old_bgcolor;
-        } else {
-            fgcolor = bgcolor = NULL;
-        }
-        if ((p = strstr(buffer, "\033[1;")) != NULL) {
-            p += 4;
-            color = atoi(p);
-            vt_to_gdk_color(color, &fgcolor, &bgcolor);
-
-            while (++p < buffer + len) {
-                if (*p == ';') {
-                    color = atoi(++p);
-                    vt_to_gdk_color(color, &fgcolor, &bgcolor);
-                    p += 2;
-                }
-                if (*p == 'm')
-                    break;
-            }
-            if (Xdialog.keep_colors) {
-                old_fgcolor = fgcolor;
-                old_bgcolor = bgcolor;
-            }
-            remove_vt_sequences(buffer);
+            Xdialog.file_init_size -= row.length;
         }
+        if (row.text == NULL)
+            continue;    /* end of a truncated line */
 
 #if GTK_CHECK_VERSION(2,0,0)
-        if (Xdialog.reverse) {
-            gtk_list_store_prepend (store, &iter);
-        } else {
-            gtk_list_store_append (store, &iter);
-        }
-        if (fgcolor) {
-            gtk_list_store_set (store, &iter, LOGBOX_COL_FGCOLOR, fgcolor, -1);
-        }
-        if (bgcolor) {
-            gtk_list_store_set (store, &iter, LOGBOX_COL_BGCOLOR, bgcolor, -1);
-        }
-        gtk_list_store_set (store, &iter, LOGBOX_COL_TEXT, buffer, -1);
-
+        gtk_list_store_insert_with_values (store, NULL, Xdialog.reverse ? 0 : -1,
+                                           LOGBOX_COL_TEXT,    row.text,
+                                           LOGBOX_COL_FGCOLOR, row.fgcolor,
+                                           LOGBOX_COL_BGCOLOR, row.bgcolor,
+                                           LOGBOX_COL_DATE,    Xdialog.time_stamp ? row.stamp : NULL,
+                                           -1);
 #else // -- GTK1 --
         if (Xdialog.reverse) {
             rownum = gtk_clist_prepend (clist, null_row);
@@ -608,66 +592,150 @@ gboolean logbox_timeout(gpointer data)
             rownum = gtk_clist_append (clist, null_row);
         }
         gtk_clist_set_selectable (clist, rownum, FALSE);
-        if (fgcolor) {
-            gtk_clist_set_foreground (clist, rownum, fgcolor);
-        }
-        if (bgcolor) {
-            gtk_clist_set_background (clist, rownum, bgcolor);
+        if (row.fgcolor) {
+            gtk_clist_set_foreground (clist, rownum, row.fgcolor);
         }
-        if (!Xdialog.time_stamp) {
-            gtk_clist_set_text (clist, rownum, 0, buffer);
+        if (row.bgcolor) {
+            gtk_clist_set_background (clist, rownum, row.bgcolor);
         }
-#endif
-
-        if (Xdialog.time_stamp)
-        {
-#if GTK_MAJOR_VERSION == 1 // -- GTK1 --
-            gtk_clist_set_text (clist, rownum, 1, buffer);
-#endif
-            if (Xdialog.date_stamp) {
-                sprintf(buffer, "%02d/%02d/%d %02d:%02d:%02d ",
-                        localdate->tm_mday, localdate->tm_mon+1, localdate->tm_year+1900,
-                        localdate->tm_hour, localdate->tm_min, localdate->tm_sec);
-            } else {
-                sprintf(buffer, "%02d:%02d:%02d",
-                        localdate->tm_hour, localdate->tm_min, localdate->tm_sec);
-            }
-#if GTK_CHECK_VERSION(2,0,0)
-            gtk_list_store_set (store, &iter, LOGBOX_COL_DATE, buffer, -1);
-#else // -- GTK1 --
-            gtk_clist_set_text (clist, rownum, 0, buffer);
-#endif
+        if (Xdialog.time_stamp) {
+            gtk_clist_set_text (clist, rownum, 0, row.stamp);
+            gtk_clist_set_text (clist, rownum, 1, row.text);
+        } else {
+            gtk_clist_set_text (clist, rownum, 0, row.text);
         }
-
-#if GTK_MAJOR_VERSION == 1 // -- GTK1 --
         gtk_clist_columns_autosize(clist);
 #endif
+        trace_input(1);
 
+#if GLIB_CHECK_VERSION(2,32,0)
+        if (Xdialog.file_init_size <= 0 && g_get_monotonic_time() >= end)
+            break;
+#else
         if (!empty_gtk_queue()) {
             return FALSE;
         }
+#endif
     }
 
     return TRUE;
 }
 
 
+// ------------------------------------------------------------------------------------------
+//                  periodic and changes reporting (--interval, --report-changes)
+// ------------------------------------------------------------------------------------------
+
+/* --interval timer: "data" is the widget result printer, the output being
+ * flushed so that a buffered stream (--stdout, --output-fd) reports in time.
+ */
+gboolean interval_report(gpointer data)
+{
+    GSourceFunc printer = (GSourceFunc) data;
+
+    printer(NULL);
+    fflush(Xdialog.output);
+    return TRUE;
+}
+
+/* The widget changes schedule a report (the idle source being kept into
+ * Xdialog.timer, unused without --interval), so that a burst of changes
+ * gives a single report.  The result is then printed by the widget --interval
+ * function into report_file, and only output when it differs from the last
+ * reported one.
+ */
+static GSourceFunc report_printer = NULL;
+static FILE       *report_file    = NULL;
+static gchar      *report_last    = NULL;
+static long        report_length  = 0;
+static guint       report_count   = 0;
+
+static gboolean report_idle(gpointer data)
+{
+    FILE *output = Xdialog.output;
+    gchar *result;
+    long length;
+
+    Xdialog.timer = 0;
+    if (report_file == NULL && (report_file = tmpfile()) == NULL) {
+        return FALSE;
+    }
+    rewind(report_file);
+    Xdialog.output = report_file;
+    report_printer(NULL);
+    Xdialog.output = output;
+
+    length = ftell(report_file);
+    result = g_malloc(length + 1);
+    rewind(report_file);
+    length = fread(result, 1, length, report_file);
+    result[length] = 0;
+
+    /* the results may hold NULs (--output-format nul) */
+    if (report_last != NULL && length == report_length &&
+        memcmp(result, report_last, length) == 0) {
+        g_free(result);
+        return FALSE;
+    }
+    if (Xdialog.report_sequence) {
+        fprintf(Xdialog.output, "%u\t", ++report_count);
+    }
+    /* an empty selection is reported as an empty record */
+    if (length > 0)
+        fwrite(result, 1, length, Xdialog.output);
+    else
+        fputc(Xdialog.output_format == OUTPUT_NUL ? '\0' : '\n', Xdialog.output);
+    fflush(Xdialog.output);
+    g_free(report_last);
+    report_last = result;
+    report_length = length;
+    return FALSE;
+}
+
+/* Sets the function printing the widget result, the first report being
+ * made once the dialog is set up */
+void report_changes_init(GSourceFunc printer)
+{
+    report_changes_free();
+    report_printer = printer;
+    report_changed(NULL, NULL);
+}
+
+void report_changes_free(void)
+{
+    if (report_file != NULL) {
+        fclose(report_file);
+        report_file = NULL;
+    }
+    g_free(report_last);
+    report_last = NULL;
+    report_count = 0;
+    report_printer = NULL;
+}
+
+/* Handler of the signals telling the widget result changed */
+void report_changed(gpointer object, gpointer data)
+{
+    if (report_printer != NULL && Xdialog.timer == 0) {
+        Xdialog.timer = g_idle_add(report_idle, NULL);
+    }
+}
+
+
 // ------------------------------------------------------------------------------------------
 //                   inputboxes and combobox callbacks
 // ------------------------------------------------------------------------------------------
 
 gint inputbox_ok(gpointer object, gpointer data)
 {
-    fprintf(Xdialog.output, "%s",
-        gtk_entry_get_text(GTK_ENTRY(Xdialog.widget1)));
+    result_begin();
+    result_add(gtk_entry_get_text(GTK_ENTRY(Xdialog.widget1)));
     if (Xdialog.widget2 != NULL)
-        fprintf(Xdialog.output, "%s%s", Xdialog.separator,
-            gtk_entry_get_text(GTK_ENTRY(Xdialog.widget2)));
+        result_add(gtk_entry_get_text(GTK_ENTRY(Xdialog.widget2)));
     if (Xdialog.widget3 != NULL)
-        fprintf(Xdialog.output, "%s%s", Xdialog.separator,
-            gtk_entry_get_text(GTK_ENTRY(Xdialog.widget3)));
-    fprintf(Xdialog.output, "\n");
-        
+        result_add(gtk_entry_get_text(GTK_ENTRY(Xdialog.widget3)));
+    result_end();
+
     return TRUE;
 }
 
@@ -678,6 +746,194 @@ gboolean inputbox_timeout(gpointer data)
 }
 
 
+#if GTK_CHECK_VERSION(2,4,0)
+
+/* Large comboboxes (see create_combobox()): the items are sorted (case being
+ * ignored) into combo_index, so that those starting with the entry text are
+ * found by a binary search, and only the first COMBOBOX_MAX_COMPLETIONS of
+ * them are put into the completion model.  The full list, in the order of the
+ * items, is popped up by the entry icon (see set_combo_popup()).
+ */
+static gint *combo_index = NULL;
+static gint  combo_size  = 0;
+
+static gint compare_combo_items (gconstpointer a, gconstpointer b, gpointer data)
+{
+    return g_ascii_strcasecmp (item_name(&Xdialog.array[*(const gint *) a]),
+                               item_name(&Xdialog.array[*(const gint *) b]));
+}
+
+void combo_index_init (gint list_size)
+{
+    gint i;
+
+    combo_index_free ();
+    combo_index = g_new (gint, list_size);
+    for (i = 0; i < list_size; i++) {
+        combo_index[i] = i;
+    }
+    combo_size = list_size;
+    g_qsort_with_data (combo_index, list_size, sizeof(gint), compare_combo_items, NULL);
+}
+
+void combo_index_free (void)
+{
+    g_free (combo_index);
+    combo_index = NULL;
+    combo_size = 0;
+}
+
+/* First sorted item which "len" first characters are not lower than those
+ * of "text" (with len = strlen(text) + 1, the full strings are compared).
+ */
+static gint combo_search (const gchar *text, gsize len)
+{
+    gint low = 0, high = combo_size, middle;
+
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (g_ascii_strncasecmp (item_name(&Xdialog.array[combo_index[middle]]),
+                                 text, len) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+static gboolean combo_has_item (const gchar *text)
+{
+    const gchar *name;
+    gint k;
+
+    for (k = combo_search (text, strlen (text) + 1); k < combo_size; k++) {
+        name = item_name(&Xdialog.array[combo_index[k]]);
+        if (g_ascii_strcasecmp (name, text) != 0)
+            break;
+        if (strcmp (name, text) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* Entry "changed" handler, connected before the one of the completion so
+ * that the completion model ("data") is up to date when it is refiltered.
+ */
+void combo_entry_changed (GtkEditable *editable, gpointer data)
+{
+    GtkListStore *store = GTK_LIST_STORE(data);
+    GtkWidget *button_ok;
+    const gchar *text = gtk_entry_get_text (GTK_ENTRY(editable));
+    const gchar *name;
+    gsize len = strlen (text);
+    gint k, n = 0;
+
+    gtk_list_store_clear (store);
+    for (k = combo_search (text, len); k < combo_size && n < COMBOBOX_MAX_COMPLETIONS; k++) {
+        name = item_name(&Xdialog.array[combo_index[k]]);
+        if (g_ascii_strncasecmp (name, text, len) != 0)
+            break;
+        gtk_list_store_insert_with_values (store, NULL, n++, 0, name, -1);
+    }
+
+    /* Without --editable, only an item may be validated */
+    button_ok = g_object_get_data (G_OBJECT(editable), "ok_button");
+    if (button_ok != NULL) {
+        gtk_widget_set_sensitive (button_ok, combo_has_item (text));
+    }
+}
+
+/* The completion rows are those of the model, already matching the text */
+gboolean combo_completion_match (GtkEntryCompletion *completion, const gchar *key,
+                                 GtkTreeIter *iter, gpointer data)
+{
+    return TRUE;
+}
+
+#if GTK_CHECK_VERSION(2,16,0)
+/* The entry icon pops the full list ("data") up below the entry, as the combo
+ * button would, the cursor being on the item in the entry, if any.
+ */
+void combo_icon_press (GtkEntry *entry, GtkEntryIconPosition position,
+                       GdkEvent *event, gpointer data)
+{
+    GtkWidget *popup = GTK_WIDGET(data);
+    GtkTreeView *treeview = g_object_get_data (G_OBJECT(popup), "treeview");
+    GtkAllocation allocation;
+    GtkTreePath *path;
+    const gchar *text = gtk_entry_get_text (entry);
+    gint x, y, k;
+
+    gdk_window_get_origin (gtk_widget_get_window (GTK_WIDGET(entry)), &x, &y);
+    gtk_widget_get_allocation (GTK_WIDGET(entry), &allocation);
+    if (!gtk_widget_get_has_window (GTK_WIDGET(entry))) {
+        x += allocation.x;
+        y += allocation.y;
+    }
+    gtk_widget_set_size_request (popup, allocation.width, -1);
+    gtk_window_move (GTK_WINDOW(popup), x, y + allocation.height);
+
+    k = combo_search (text, strlen (text) + 1);
+    if (k < combo_size &&
+        g_ascii_strcasecmp (item_name(&Xdialog.array[combo_index[k]]), text) == 0) {
+        path = gtk_tree_path_new_from_indices (combo_index[k], -1);
+        gtk_tree_view_set_cursor (treeview, path, NULL, FALSE);
+        gtk_tree_view_scroll_to_cell (treeview, path, NULL, TRUE, 0.5, 0.0);
+        gtk_tree_path_free (path);
+    }
+    gtk_widget_show (popup);
+    gtk_window_present (GTK_WINDOW(popup));
+    gtk_widget_grab_focus (GTK_WIDGET(treeview));
+}
+
+/* An item of the list is chosen: it goes into the entry ("data") */
+void combo_popup_activated (GtkTreeView *treeview, GtkTreePath *path,
+                            GtkTreeViewColumn *column, gpointer data)
+{
+    GtkWidget *popup = gtk_widget_get_toplevel (GTK_WIDGET(treeview));
+    gint i = gtk_tree_path_get_indices (path)[0];
+
+    gtk_widget_hide (popup);
+    gtk_entry_set_text (GTK_ENTRY(data), item_name(&Xdialog.array[i]));
+    gtk_editable_set_position (GTK_EDITABLE(data), -1);
+    gtk_widget_grab_focus (GTK_WIDGET(data));
+}
+
+/* A click on a row chooses it, as in a menu */
+gboolean combo_popup_click (GtkWidget *widget, GdkEventButton *event, gpointer data)
+{
+    GtkTreeView *treeview = GTK_TREE_VIEW(widget);
+    GtkTreePath *path;
+
+    if (event->button != 1 || event->window != gtk_tree_view_get_bin_window (treeview) ||
+        !gtk_tree_view_get_path_at_pos (treeview, (gint) event->x, (gint) event->y,
+                                        &path, NULL, NULL, NULL)) {
+        return FALSE;
+    }
+    combo_popup_activated (treeview, path, NULL, data);
+    gtk_tree_path_free (path);
+    return TRUE;
+}
+
+gboolean combo_popup_keypress (GtkWidget *popup, GdkEventKey *event, gpointer data)
+{
+    if (event->keyval == GDK_KEY(Escape)) {
+        gtk_widget_hide (popup);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+gboolean combo_popup_focus_out (GtkWidget *popup, GdkEventFocus *event, gpointer data)
+{
+    gtk_widget_hide (popup);
+    return FALSE;
+}
+#endif
+
+#endif
+
+
 gint input_keypress(GtkWidget *entry, GdkEventKey *event, gpointer data)
 {
     if (event->type == GDK_KEY_PRESS
@@ -689,12 +945,9 @@ gint input_keypress(GtkWidget *entry, GdkEventKey *event, gpointer data)
             Xdialog.exit_code = 0;
         }
         if (Xdialog.check) {
-            if (Xdialog.checked)
-                fprintf(Xdialog.output, "checked\n");
-            else
-                fprintf(Xdialog.output, "unchecked\n");
+            result_print(Xdialog.checked ? "checked" : "unchecked");
         }
-        gtk_widget_destroy(Xdialog.window);
+        close_window();
         return FALSE;
     }
     return TRUE;
@@ -744,36 +997,285 @@ gboolean editbox_ok(gpointer object, gpointer data)
 
 /* The print button callback (used by editbox, textbox and tailbox) */
 
+#if GTK_CHECK_VERSION(2,0,0)
+
+/* The text is not copied as a whole: it is streamed to the print command pipe
+ * in PRINT_CHUNK_SIZE segments, from an output watch on the pipe, so that the
+ * GUI keeps running while the spooler reads. A textbox showing an unmodified
+ * file gets that file copied to the pipe as is.  The print command is reaped
+ * from a child watch, and SIGPIPE is ignored while the job runs (a command
+ * exiting early must not kill Xdialog).
+ */
+typedef struct {
+    GPid          pid;         /* print command, 0 once reaped */
+    int           pipe;        /* its stdin, -1 once closed */
+    struct sigaction sigpipe;  /* SIGPIPE disposition before the job */
+    GIOChannel *  channel;
+    guint         watch;
+    int           fd;          /* file to copy, or -1 to read the text buffer */
+    GtkTextBuffer *buffer;
+    GtkTextMark * mark;        /* start of the next text buffer segment */
+    gchar *       data;        /* current segment */
+    gsize         len;
+    gsize         pos;
+    gsize         done;        /* bytes (file) or characters (text buffer) */
+    gsize         total;
+    gboolean      failed;
+    GtkWidget *   status_bar;
+    guint         status_id;
+} print_job;
+
+static print_job *printing = NULL;
+
+static void print_status(print_job *job, const gchar *msg)
+{
+    if (job->status_bar == NULL) {
+        return;
+    }
+    gtk_statusbar_pop  (GTK_STATUSBAR(job->status_bar), job->status_id);
+    gtk_statusbar_push (GTK_STATUSBAR(job->status_bar), job->status_id, msg);
+}
+
+static gboolean print_next_segment(print_job *job)
+{
+    GtkTextIter start_iter, end_iter;
+    ssize_t nchars;
+
+    if (job->fd >= 0) {
+        if (job->data == NULL) {
+            job->data = g_malloc(PRINT_CHUNK_SIZE);
+        }
+        nchars = read(job->fd, job->data, PRINT_CHUNK_SIZE);
+        if (nchars <= 0) {
+            job->failed = (nchars < 0);
+            return FALSE;
+        }
+        job->len   = nchars;
+        job->done += nchars;
+    } else {
+        gtk_text_buffer_get_iter_at_mark (job->buffer, &start_iter, job->mark);
+        if (gtk_text_iter_is_end(&start_iter)) {
+            return FALSE;
+        }
+        end_iter = start_iter;
+        gtk_text_iter_forward_chars (&end_iter, PRINT_CHUNK_SIZE);
+        g_free(job->data);
+        job->data  = gtk_text_buffer_get_text (job->buffer, &start_iter, &end_iter, FALSE);
+        /* the segment is UTF-8: its length in bytes is what is written */
+        job->len   = strlen(job->data);
+        job->done += gtk_text_iter_get_offset(&end_iter) - gtk_text_iter_get_offset(&start_iter);
+        gtk_text_buffer_move_mark (job->buffer, job->mark, &end_iter);
+    }
+    job->pos = 0;
+    return TRUE;
+}
+
+/* Once the pipe is closed and the print command has exited */
+static void print_done(print_job *job)
+{
+    print_status(job, job->failed ? PRINT_FAILED : PRINT_DONE);
+    g_free(job);
+    printing = NULL;
+}
+
+static void print_exited(GPid pid, gint status, gpointer data)
+{
+    print_job *job = (print_job *) data;
+
+    g_spawn_close_pid(pid);
+    job->pid = 0;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        job->failed = TRUE;
+    }
+    if (job->pipe < 0) {
+        print_done(job);
+    }
+}
+
+/* All of the data is written (or the job failed): the pipe is closed, the
+ * job being done once the print command has exited as well.
+ */
+static void print_finish(print_job *job)
+{
+    if (job->watch != 0) {
+        g_source_remove(job->watch);
+    }
+    g_io_channel_unref(job->channel);
+    close(job->pipe);
+    job->pipe = -1;
+    sigaction(SIGPIPE, &job->sigpipe, NULL);
+    if (job->fd >= 0) {
+        close(job->fd);
+    } else {
+        gtk_text_buffer_delete_mark (job->buffer, job->mark);
+        g_object_unref (job->buffer);
+    }
+    g_free(job->data);
+    job->data = NULL;
+    if (job->pid == 0) {
+        print_done(job);
+    }
+}
+
+static gboolean print_write(GIOChannel *source, GIOCondition condition, gpointer data)
+{
+    print_job *job = (print_job *) data;
+    gchar msg[64];
+    ssize_t nchars;
+
+    if (condition & (G_IO_ERR | G_IO_HUP)) {
+        job->failed = TRUE;
+    } else if (job->pos < job->len || print_next_segment(job)) {
+        /* One write per dispatch: the watch fires again as long as the
+         * pipe can take more data */
+        nchars = write(g_io_channel_unix_get_fd(source),
+                       job->data + job->pos, job->len - job->pos);
+        if (nchars >= 0) {
+            job->pos += nchars;
+            if (job->total > 0) {
+                snprintf(msg, sizeof(msg), PRINT_PROGRESS,
+                         (int) (MIN(job->done, job->total) * 100 / job->total));
+                print_status(job, msg);
+            }
+            return TRUE;
+        }
+        if (errno == EAGAIN || errno == EINTR) {
+            return TRUE;
+        }
+        job->failed = TRUE;
+    }
+    job->watch = 0;
+    print_finish(job);
+    return FALSE;
+}
+
+/* Called when the window is destroyed while printing: the remaining data is
+ * written synchronously so that nothing is lost.
+ */
+static void print_flush(void)
+{
+    print_job *job = printing;
+    int fd;
+    ssize_t nchars;
+
+    if (job == NULL) {
+        return;
+    }
+    job->status_bar = NULL;
+    if (job->pipe < 0) {    /* only waiting for the print command */
+        return;
+    }
+    fd = job->pipe;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    while (!job->failed && (job->pos < job->len || print_next_segment(job))) {
+        nchars = write(fd, job->data + job->pos, job->len - job->pos);
+        if (nchars < 0 && errno != EINTR) {
+            job->failed = TRUE;
+        } else if (nchars > 0) {
+            job->pos += nchars;
+        }
+    }
+    print_finish(job);
+}
+
 gboolean print_text(gpointer object, gpointer data)
 {
-    int length;
     char cmd[MAX_PRTCMD_LENGTH];
-    FILE * temp;
-    char *buffer;
-    
+    gchar *argv[] = { "/bin/sh", "-c", cmd, NULL };
+    GtkTextBuffer *text_buffer;
+    GtkTextIter start_iter;
+    struct sigaction ignore;
+    struct stat sb;
+    print_job *job;
+    int fd;
+
+    if (printing != NULL) {
+        return TRUE;
+    }
     strncpy(cmd, PRINTER_CMD, sizeof(cmd));
     if (strlen(Xdialog.printer) != 0) {
         strncat(cmd, " "PRINTER_CMD_OPTION, sizeof(cmd));
         strncat(cmd, Xdialog.printer, sizeof(cmd));
     }
-#if GTK_CHECK_VERSION(2,0,0)
-    GtkTextIter start_iter;
-    GtkTextIter end_iter;
-    GtkTextBuffer *text_buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(Xdialog.widget1));
 
-    gtk_text_buffer_get_bounds (text_buffer, &start_iter, &end_iter);
+    job = g_new0(print_job, 1);
+    job->fd = -1;
+    text_buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(Xdialog.widget1));
+    if (Xdialog.print_file != NULL && !gtk_text_buffer_get_modified(text_buffer)) {
+        job->fd = open(Xdialog.print_file, O_RDONLY);
+        if (job->fd >= 0 && fstat(job->fd, &sb) == 0) {
+            job->total = sb.st_size;
+        }
+    }
+    if (job->fd < 0) {
+        job->buffer = g_object_ref(text_buffer);
+        gtk_text_buffer_get_start_iter(text_buffer, &start_iter);
+        job->mark  = gtk_text_buffer_create_mark(text_buffer, NULL, &start_iter, TRUE);
+        job->total = gtk_text_buffer_get_char_count(text_buffer);
+    }
 
-    length = gtk_text_buffer_get_char_count (text_buffer);
-    buffer = gtk_text_buffer_get_text (text_buffer, &start_iter, &end_iter, FALSE);
-#else
+    /* As popen(), the command gets our stdout and stderr */
+    if (!g_spawn_async_with_pipes(NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
+                                  NULL, NULL, &job->pid, &job->pipe,
+                                  NULL, NULL, NULL)) {
+        if (job->fd >= 0) {
+            close(job->fd);
+        } else {
+            gtk_text_buffer_delete_mark(text_buffer, job->mark);
+            g_object_unref(text_buffer);
+        }
+        g_free(job);
+        return TRUE;
+    }
+    fd = job->pipe;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    g_child_watch_add(job->pid, print_exited, job);
+    memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&ignore.sa_mask);
+    sigaction(SIGPIPE, &ignore, &job->sigpipe);
+
+    /* Progress is reported into a status bar set up on the first print */
+    job->status_bar = g_object_get_data(G_OBJECT(Xdialog.vbox), "print_status_bar");
+    if (job->status_bar == NULL) {
+        job->status_bar = gtk_statusbar_new();
+        gtk_box_pack_end (Xdialog.vbox, job->status_bar, FALSE, FALSE, 0);
+        gtk_widget_show (job->status_bar);
+        g_object_set_data(G_OBJECT(Xdialog.vbox), "print_status_bar", job->status_bar);
+    }
+    job->status_id = gtk_statusbar_get_context_id(GTK_STATUSBAR(job->status_bar), "print");
+    print_status(job, PRINT_STARTED);
+
+    job->channel = g_io_channel_unix_new(fd);
+    job->watch   = g_io_add_watch(job->channel, G_IO_OUT | G_IO_ERR | G_IO_HUP,
+                                  print_write, job);
+    printing = job;
+
+    return TRUE;
+}
+
+#else // -- GTK1 --
+
+gboolean print_text(gpointer object, gpointer data)
+{
+    int length;
+    char cmd[MAX_PRTCMD_LENGTH];
+    FILE * temp;
+    char *buffer;
     int i;
+
+    strncpy(cmd, PRINTER_CMD, sizeof(cmd));
+    if (strlen(Xdialog.printer) != 0) {
+        strncat(cmd, " "PRINTER_CMD_OPTION, sizeof(cmd));
+        strncat(cmd, Xdialog.printer, sizeof(cmd));
+    }
     length = gtk_text_get_length (GTK_TEXT(Xdialog.widget1));
     buffer = g_malloc ((length+1)*sizeof(gchar));
     for (i = 0; i < length; i++)
     {
         buffer[i] = GTK_TEXT_INDEX(GTK_TEXT(Xdialog.widget1), i);
     }
-#endif
     temp = popen(cmd, "w");
     if (temp != NULL) {
         fwrite (buffer, sizeof(gchar), length, temp);
@@ -784,6 +1286,8 @@ gboolean print_text(gpointer object, gpointer data)
     return TRUE;
 }
 
+#endif
+
 
 // ------------------------------------------------------------------------------------------
 //                           rangebox callbacks
@@ -794,20 +1298,21 @@ gboolean rangebox_exit(GtkButton *button, gpointer data)
     GtkAdjustment *adj;
     gdouble value;
 
+    result_begin();
     adj = GTK_ADJUSTMENT(Xdialog.widget1);
     value = gtk_adjustment_get_value (adj);
-    fprintf(Xdialog.output, "%d", (gint) value);
+    result_add_printf("%d", (gint) value);
     if (Xdialog.widget2 != NULL) {
         adj = GTK_ADJUSTMENT(Xdialog.widget2);
-        fprintf(Xdialog.output, "%s%d", Xdialog.separator,
-        (gint) value);
+        value = gtk_adjustment_get_value (adj);
+        result_add_printf("%d", (gint) value);
     }
     if (Xdialog.widget3 != NULL) {
         adj = GTK_ADJUSTMENT(Xdialog.widget3);
-        fprintf(Xdialog.output, "%s%d", Xdialog.separator,
-            (gint) value);
+        value = gtk_adjustment_get_value (adj);
+        result_add_printf("%d", (gint) value);
     }
-    fprintf(Xdialog.output, "\n");
+    result_end();
 
     return TRUE;
 }
@@ -825,18 +1330,19 @@ gboolean rangebox_timeout(gpointer data)
 
 gboolean spinbox_exit(GtkButton *button, gpointer data)
 {
-    fprintf(Xdialog.output, "%d",
+    result_begin();
+    result_add_printf("%d",
         gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(Xdialog.widget1)));
 
     if (Xdialog.widget2 != NULL)
-        fprintf(Xdialog.output, "%s%d", Xdialog.separator,
+        result_add_printf("%d",
             gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(Xdialog.widget2)));
 
     if (Xdialog.widget3 != NULL)
-        fprintf(Xdialog.output, "%s%d", Xdialog.separator,
+        result_add_printf("%d",
             gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(Xdialog.widget3)));
 
-    fprintf(Xdialog.output, "\n");
+    result_end();
 
     return TRUE;
 }
@@ -858,23 +1364,20 @@ void item_toggle(GtkWidget *item, int i)
         Xdialog.array[i].state = 1;
     } else
         Xdialog.array[i].state = 0;
+    report_changed(NULL, NULL);
 }
 
 gboolean print_items(GtkButton *button, gpointer data)
 {
     int i;
-    gboolean flag = FALSE;
 
+    result_begin();
     for (i = 0 ; Xdialog.array[i].state != -1 ; i++) {
         if (Xdialog.array[i].state) {
-            if (flag)
-                fprintf(Xdialog.output, "%s", Xdialog.separator);
-            fprintf(Xdialog.output, "%s", Xdialog.array[i].tag);
-            flag = TRUE;
+            result_add(item_tag(&Xdialog.array[i]));
         }
     }
-    if (flag)
-        fprintf(Xdialog.output, "\n");
+    result_end();
 
     return TRUE;
 }
@@ -884,6 +1387,355 @@ gboolean itemlist_timeout(gpointer data)
     return print_items(NULL, NULL);
 }
 
+#if GTK_CHECK_VERSION(2,0,0)
+
+/* Toggles the item of a checklist/radiolist row (see create_itemlist()): only
+ * the Xdialog.array states change, the view is just redrawn.
+ */
+static void itemlist_toggle_row (GtkTreeModel *model, GtkTreePath *path, gint type)
+{
+    GtkTreeIter iter;
+    gint i, radio_item;
+    gboolean sensitive;
+
+    if (!gtk_tree_model_get_iter (model, &iter, path))
+        return;
+    gtk_tree_model_get (model, &iter,
+                        ITEMLIST_COL_INDEX, &i,
+                        ITEMLIST_COL_SENSITIVE, &sensitive,
+                        -1);
+    if (!sensitive)
+        return;
+
+    if (type == RADIOLIST) {
+        radio_item = GPOINTER_TO_INT(g_object_get_data (G_OBJECT(Xdialog.widget1),
+                                                        "radio_item"));
+        Xdialog.array[radio_item].state = 0;
+        Xdialog.array[i].state = 1;
+        g_object_set_data (G_OBJECT(Xdialog.widget1), "radio_item", GINT_TO_POINTER(i));
+    } else {
+        Xdialog.array[i].state = !Xdialog.array[i].state;
+    }
+    gtk_widget_queue_draw (Xdialog.widget1);
+    report_changed (NULL, NULL);
+}
+
+void itemlist_toggled (GtkCellRendererToggle *cell, gchar *path_string, gpointer data)
+{
+    GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW(Xdialog.widget1));
+    GtkTreePath *path   = gtk_tree_path_new_from_string (path_string);
+
+    itemlist_toggle_row (model, path, GPOINTER_TO_INT(data));
+    gtk_tree_path_free (path);
+}
+
+/* Return/space toggle the row under the cursor, double-clicks being taken
+ * as an OK button click (see double_click_event()).
+ */
+void itemlist_row_activated (GtkTreeView *tree_view, GtkTreePath *path,
+                             GtkTreeViewColumn *column, gpointer data)
+{
+    GdkEvent *event = gtk_get_current_event ();
+
+    if (event != NULL && event->type == GDK_KEY_PRESS) {
+        itemlist_toggle_row (gtk_tree_view_get_model (tree_view), path,
+                             GPOINTER_TO_INT(data));
+    }
+    if (event != NULL) {
+        gdk_event_free (event);
+    }
+}
+
+gboolean itemlist_query_tooltip (GtkWidget *widget, gint x, gint y, gboolean keyboard_mode,
+                                 GtkTooltip *tooltip, gpointer data)
+{
+    GtkTreeModel *model;
+    GtkTreePath *path;
+    GtkTreeIter iter;
+    gint i;
+
+    if (!gtk_tree_view_get_tooltip_context (GTK_TREE_VIEW(widget), &x, &y, keyboard_mode,
+                                            &model, &path, &iter)) {
+        return FALSE;
+    }
+    gtk_tree_model_get (model, &iter, ITEMLIST_COL_INDEX, &i, -1);
+    gtk_tree_view_set_tooltip_row (GTK_TREE_VIEW(widget), tooltip, path);
+    gtk_tree_path_free (path);
+
+    if (Xdialog.array[i].tips_len == 0) {
+        return FALSE;
+    }
+    gtk_tooltip_set_text (tooltip, item_tips(&Xdialog.array[i]));
+    return TRUE;
+}
+
+#endif
+
+
+// ------------------------------------------------------------------------------------------
+//                     menu and list filter callbacks (--filter)
+// ------------------------------------------------------------------------------------------
+
+#if GTK_CHECK_VERSION(2,0,0)
+
+/* The items matching the filter text are flagged into filter_visible and their
+ * indices kept into filter_matches: as long as the new text holds the old one
+ * (i.e. while the user types), only the previous matches are checked again, so
+ * that each keystroke narrows a shrinking set instead of rescanning the list.
+ * Only the rows whose flag changed are then shown or hidden, through their
+ * child model rows (filter_rows, mapped again after rows are added or
+ * removed), the view being refiltered as a whole when most of them change.
+ */
+static gchar  *filter_text    = NULL;    /* text of the current matches */
+static gint   *filter_matches = NULL;    /* indices of the matching items */
+static gint    filter_count   = 0;
+static guint8 *filter_visible = NULL;    /* one flag per item */
+static gint    filter_size    = 0;
+static gint    filter_column  = 0;       /* model column of the items */
+static GtkTreeModel *filter_model = NULL;    /* child model of filter_rows */
+static GtkTreeIter  *filter_rows  = NULL;    /* row of each item in it */
+static gboolean      filter_rows_valid = FALSE;
+
+void list_filter_init (gint list_size, gint column)
+{
+    list_filter_free ();
+    filter_size    = list_size;
+    filter_column  = column;
+    filter_visible = g_malloc (list_size);
+    memset (filter_visible, 1, list_size);
+}
+
+void list_filter_free (void)
+{
+    if (filter_model != NULL) {
+        g_signal_handlers_disconnect_matched (G_OBJECT(filter_model), G_SIGNAL_MATCH_DATA,
+                                              0, 0, NULL, NULL, &filter_rows_valid);
+        g_object_remove_weak_pointer (G_OBJECT(filter_model), (gpointer *) &filter_model);
+    }
+    g_free (filter_text);
+    g_free (filter_matches);
+    g_free (filter_visible);
+    g_free (filter_rows);
+    filter_text    = NULL;
+    filter_matches = NULL;
+    filter_visible = NULL;
+    filter_model   = NULL;
+    filter_rows    = NULL;
+    filter_rows_valid = FALSE;
+    filter_count   = filter_size = 0;
+}
+
+/* Case insensitive (ASCII) substring search */
+static gboolean contains (const gchar *haystack, const gchar *needle, gsize len)
+{
+    gchar first = g_ascii_tolower (*needle);
+
+    for (; *haystack != '\0'; haystack++) {
+        if (g_ascii_tolower (*haystack) == first &&
+            g_ascii_strncasecmp (haystack, needle, len) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static gboolean item_matches (gint i, const gchar *text, gsize len)
+{
+    listname *item = &Xdialog.array[i];
+
+    return (Xdialog.tags && contains (item_tag(item), text, len)) ||
+           contains (item_name(item), text, len);
+}
+
+/* Makes room for the i-th item, added once the dialog is shown (--control-fd) */
+void list_filter_add (gint i)
+{
+    if (filter_visible == NULL || i < filter_size) {
+        return;
+    }
+    filter_size    = i + 1;
+    filter_visible = g_realloc (filter_visible, filter_size);
+    filter_visible[i] = filter_matches == NULL ||
+                        item_matches (i, filter_text, strlen (filter_text));
+    if (filter_matches != NULL) {
+        filter_matches = g_renew (gint, filter_matches, filter_size);
+        if (filter_visible[i]) {
+            filter_matches[filter_count++] = i;
+        }
+    }
+}
+
+gboolean list_filter_item_visible (gint i)
+{
+    return filter_visible == NULL || filter_visible[i];
+}
+
+/* Index of the item of a row, "column" holding the item index (G_TYPE_INT)
+ * or its listname pointer: FALSE for a row being appended.
+ */
+static gboolean row_item (GtkTreeModel *model, GtkTreeIter *iter, gint column, gint *i)
+{
+    listname *item;
+
+    if (gtk_tree_model_get_column_type (model, column) == G_TYPE_INT) {
+        gtk_tree_model_get (model, iter, column, i, -1);
+    } else {
+        gtk_tree_model_get (model, iter, column, &item, -1);
+        if (item == NULL) {
+            return FALSE;
+        }
+        *i = item - Xdialog.array;
+    }
+    return TRUE;
+}
+
+/* GtkTreeModelFilter visible function, "data" being the model column that
+ * holds the item index or its listname pointer.
+ */
+gboolean list_filter_visible (GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+{
+    gint i;
+
+    if (filter_visible == NULL) {
+        return TRUE;
+    }
+    return row_item (model, iter, GPOINTER_TO_INT(data), &i) && filter_visible[i];
+}
+
+static void filter_rows_inserted (GtkTreeModel *model, GtkTreePath *path,
+                                  GtkTreeIter *iter, gpointer data)
+{
+    filter_rows_valid = FALSE;
+}
+
+static void filter_rows_deleted (GtkTreeModel *model, GtkTreePath *path, gpointer data)
+{
+    filter_rows_valid = FALSE;
+}
+
+static gboolean filter_map_row (GtkTreeModel *model, GtkTreePath *path,
+                                GtkTreeIter *iter, gpointer data)
+{
+    gint i;
+
+    if (row_item (model, iter, filter_column, &i) && i < filter_size) {
+        filter_rows[i] = *iter;
+    }
+    return FALSE;
+}
+
+/* Maps the items to the rows of "model", if need be: FALSE if its rows can't
+ * be kept (iterators not persistent).
+ */
+static gboolean filter_map_rows (GtkTreeModel *model)
+{
+    if (!(gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_ITERS_PERSIST)) {
+        return FALSE;
+    }
+    if (model != filter_model) {
+        if (filter_model != NULL) {
+            g_signal_handlers_disconnect_matched (G_OBJECT(filter_model), G_SIGNAL_MATCH_DATA,
+                                                  0, 0, NULL, NULL, &filter_rows_valid);
+            g_object_remove_weak_pointer (G_OBJECT(filter_model), (gpointer *) &filter_model);
+        }
+        filter_model = model;
+        g_object_add_weak_pointer (G_OBJECT(model), (gpointer *) &filter_model);
+        g_signal_connect (G_OBJECT(model), "row-inserted",
+                          G_CALLBACK(filter_rows_inserted), &filter_rows_valid);
+        g_signal_connect (G_OBJECT(model), "row-deleted",
+                          G_CALLBACK(filter_rows_deleted), &filter_rows_valid);
+        filter_rows_valid = FALSE;
+    }
+    if (!filter_rows_valid) {
+        /* the items without a row (removed) keep a NULL user_data */
+        g_free (filter_rows);
+        filter_rows = g_new0 (GtkTreeIter, filter_size);
+        gtk_tree_model_foreach (model, filter_map_row, NULL);
+        filter_rows_valid = TRUE;
+    }
+    return TRUE;
+}
+
+/* Flags the i-th item, keeping it into "changed" if its flag changes */
+static void filter_set (gint i, gboolean visible, GArray *changed)
+{
+    if (filter_visible[i] != visible) {
+        filter_visible[i] = visible;
+        g_array_append_val (changed, i);
+    }
+}
+
+void list_filter_changed (GtkEditable *editable, gpointer data)
+{
+    GtkTreeView *treeview = GTK_TREE_VIEW(data);
+    GtkTreeModel *model = gtk_tree_view_get_model (treeview);
+    GtkTreeModel *child = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER(model));
+    GtkTreeSelection *selection;
+    GtkTreePath *path;
+    GtkTreeIter iter;
+    GArray *changed = g_array_new (FALSE, FALSE, sizeof(gint));
+    const gchar *text = gtk_entry_get_text (GTK_ENTRY(editable));
+    gsize len = strlen (text);
+    gint i, m, n = 0;
+
+    if (len == 0) {
+        for (i = 0; i < filter_size; i++) {
+            filter_set (i, TRUE, changed);
+        }
+        g_free (filter_matches);
+        filter_matches = NULL;
+    } else if (filter_matches != NULL && contains (text, filter_text, strlen (filter_text))) {
+        for (i = 0; i < filter_count; i++) {
+            m = filter_matches[i];
+            filter_set (m, item_matches (m, text, len), changed);
+            if (filter_visible[m]) {
+                filter_matches[n++] = m;
+            }
+        }
+        filter_count = n;
+    } else {
+        if (filter_matches == NULL) {
+            filter_matches = g_new (gint, filter_size);
+        }
+        for (i = 0; i < filter_size; i++) {
+            filter_set (i, item_matches (i, text, len), changed);
+            if (filter_visible[i]) {
+                filter_matches[n++] = i;
+            }
+        }
+        filter_count = n;
+    }
+    g_free (filter_text);
+    filter_text = g_strdup (text);
+
+    /* show or hide the rows whose flag changed, or refilter them all */
+    if (changed->len > (guint) filter_size / 2 || !filter_map_rows (child)) {
+        gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER(model));
+    } else {
+        for (i = 0; i < (gint) changed->len; i++) {
+            m = g_array_index (changed, gint, i);
+            if (filter_rows[m].user_data == NULL) {
+                continue;
+            }
+            path = gtk_tree_model_get_path (child, &filter_rows[m]);
+            gtk_tree_model_row_changed (child, path, &filter_rows[m]);
+            gtk_tree_path_free (path);
+        }
+    }
+    g_array_free (changed, TRUE);
+
+    /* A menu must keep a selected row */
+    selection = gtk_tree_view_get_selection (treeview);
+    if (gtk_tree_selection_get_mode (selection) == GTK_SELECTION_BROWSE &&
+        !gtk_tree_selection_get_selected (selection, NULL, NULL) &&
+        gtk_tree_model_get_iter_first (model, &iter)) {
+        path = gtk_tree_model_get_path (model, &iter);
+        gtk_tree_view_set_cursor (treeview, path, NULL, FALSE);
+        gtk_tree_path_free (path);
+    }
+}
+
+#endif
+
 
 // ------------------------------------------------------------------------------------------
 //                           menubox callbacks
@@ -895,13 +1747,11 @@ static void menubox_print_selected (GtkWidget *list)
     GtkTreeSelection *selection;
     GtkTreeModel *model;
     GtkTreeIter iter;
-    gchar *tag;
+    listname *rowdata;
     selection = gtk_tree_view_get_selection (GTK_TREE_VIEW(list));
-    gtk_tree_selection_get_selected (selection, &model, &iter);
-    gtk_tree_model_get (model, &iter, 0, &tag, -1);
-    if (tag) {
-        fprintf(Xdialog.output, "%s\n", tag);
-        g_free(tag);
+    if (gtk_tree_selection_get_selected (selection, &model, &iter)) {
+        gtk_tree_model_get (model, &iter, MENUBOX_COL_ITEM, &rowdata, -1);
+        result_print(item_tag(rowdata));
     }
 
 #else // -- GTK1 --
@@ -912,14 +1762,14 @@ static void menubox_print_selected (GtkWidget *list)
     char *tag;
     gtk_clist_get_text (GTK_CLIST(list), sel_row, 0, &tag);
     if (tag) {
-        fprintf(Xdialog.output, "%s\n", tag);
+        result_print(tag);
         g_free(tag);
     }
 # else
     listname *rowdata;
     rowdata = (listname*) gtk_clist_get_row_data (GTK_CLIST(list), sel_row);
     if (rowdata) {
-        fprintf(Xdialog.output, "%s\n", rowdata->tag);
+        result_print(item_tag(rowdata));
     }
 # endif
 #endif
@@ -949,10 +1799,12 @@ void on_menubox_tip_treeview_changed (GtkTreeSelection *selection, gpointer data
     GtkTreeModel *model;
     GtkTreeIter iter;
     listname *rowdata;
-    gtk_tree_selection_get_selected (selection, &model, &iter);
-    gtk_tree_model_get (model, &iter, 2, &rowdata, -1);
+    if (!gtk_tree_selection_get_selected (selection, &model, &iter)) {
+        return;
+    }
+    gtk_tree_model_get (model, &iter, MENUBOX_COL_ITEM, &rowdata, -1);
     gtk_statusbar_pop  (GTK_STATUSBAR(data), Xdialog.status_id);
-    gtk_statusbar_push (GTK_STATUSBAR(data), Xdialog.status_id, rowdata->tips);
+    gtk_statusbar_push (GTK_STATUSBAR(data), Xdialog.status_id, item_tips(rowdata));
 }
 
 #else // GTK 1
@@ -962,7 +1814,7 @@ void on_menubox_item_select (GtkWidget *clist, gint row, gint column,
 {
     // If the tag is empty, then this is an unavailable item:
     // select back the last selected row and exit.
-    if (strlen(Xdialog.array[row].tag) == 0) {
+    if (Xdialog.array[row].tag_len == 0) {
         gtk_clist_select_row(GTK_CLIST(clist), Xdialog.array[0].state, 0);
         return;
     }
@@ -974,7 +1826,7 @@ void on_menubox_item_select (GtkWidget *clist, gint row, gint column,
     {
         gtk_statusbar_pop  (GTK_STATUSBAR(Xdialog.widget1), Xdialog.status_id);
         gtk_statusbar_push (GTK_STATUSBAR(Xdialog.widget1), Xdialog.status_id,
-                            Xdialog.array[row].tips);
+                            item_tips(&Xdialog.array[row]));
     }
 }
 
@@ -1012,9 +1864,56 @@ void print_tree_selection (GtkButton *button, gpointer data)
 #endif
 
     g_return_if_fail (rowdata != NULL);
-    fprintf(Xdialog.output, "%s\n", rowdata->tag);
+    result_print(item_tag(rowdata));
+}
+
+
+#if GTK_CHECK_VERSION(2,0,0)
+/* Adds the rows of the treeview items which first one is "first" (the items
+ * being chained through Xdialog.tree_next) as children of "parent" (NULL
+ * for the root rows).  The rows of items with children get a placeholder
+ * child (with a NULL listname), replaced by the actual children rows when
+ * the row is first expanded.
+ */
+void tree_add_children (GtkTreeStore *store, GtkTreeIter *parent, gint first)
+{
+    GtkTreeIter iter, prev;
+    gint i;
+
+    for (i = first; i >= 0; i = Xdialog.tree_next[i]) {
+        /* inserting after the previous row saves a walk of the siblings */
+        gtk_tree_store_insert_after (store, &iter, parent, i == first ? NULL : &prev);
+        gtk_tree_store_set (store, &iter,
+                            0, item_name(&Xdialog.array[i]),
+                            1, &Xdialog.array[i],
+                            -1);
+        if (tree_item_has_children (i)) {
+            gtk_tree_store_insert_with_values (store, NULL, &iter, 0,
+                                               0, "", 1, NULL, -1);
+        }
+        prev = iter;
+    }
 }
 
+gboolean tree_test_expand_row (GtkTreeView *treeview, GtkTreeIter *iter,
+                               GtkTreePath *path, gpointer data)
+{
+    GtkTreeModel *model = gtk_tree_view_get_model (treeview);
+    GtkTreeIter placeholder;
+    listname *rowdata, *childdata;
+
+    if (!gtk_tree_model_iter_children (model, &placeholder, iter))
+        return FALSE;
+    gtk_tree_model_get (model, &placeholder, 1, &childdata, -1);
+    if (childdata == NULL) {
+        /* the children go before the placeholder, which is then removed */
+        gtk_tree_model_get (model, iter, 1, &rowdata, -1);
+        tree_add_children (GTK_TREE_STORE(model), iter, rowdata - Xdialog.array + 1);
+        gtk_tree_store_remove (GTK_TREE_STORE(model), &placeholder);
+    }
+    return FALSE;
+}
+#endif
 
 void tree_selection_changed (GtkWidget *tree)
 {
@@ -1035,7 +1934,7 @@ void tree_selection_changed (GtkWidget *tree)
     rowdata = (listname*) g_object_get_data (G_OBJECT(list->data), "listitem");
 #endif
     if (rowdata) {
-        fprintf (stderr, "%s\n", rowdata->name);
+        fprintf (stderr, "%s\n", item_name(rowdata));
     }
 #endif
 }
@@ -1058,24 +1957,45 @@ void buildlist_sensitive_buttons (void)
 
     enabled1 = gtk_tree_model_get_iter_first (model1, &iter1);
     enabled2 = gtk_tree_model_get_iter_first (model2, &iter2);
-
-    gtk_widget_set_sensitive (Xdialog.widget3, enabled1);
-    gtk_widget_set_sensitive (Xdialog.widget4, enabled2);
 #else // -- GTK1 --
-    enabled1 = g_list_length(GTK_LIST(Xdialog.widget1)->children) != 0;
-    enabled2 = g_list_length(GTK_LIST(Xdialog.widget2)->children) != 0;
+    enabled1 = GTK_LIST(Xdialog.widget1)->children != NULL;
+    enabled2 = GTK_LIST(Xdialog.widget2)->children != NULL;
+#endif
     gtk_widget_set_sensitive (Xdialog.widget3, enabled1);
     gtk_widget_set_sensitive (Xdialog.widget4, enabled2);
-#endif
+    gtk_widget_set_sensitive (g_object_get_data (G_OBJECT(Xdialog.widget3), "all_button"),
+                              enabled1);
+    gtk_widget_set_sensitive (g_object_get_data (G_OBJECT(Xdialog.widget4), "all_button"),
+                              enabled2);
 }
 
+#if GTK_CHECK_VERSION(2,0,0)
+/* Both buildlist views are filters over the same store (see
+ * set_scrolled_list()), "data" being the state of the items they show.
+ */
+gboolean buildlist_row_visible (GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+{
+    listname *item;
 
+    gtk_tree_model_get (model, iter, BUILDLIST_COL_ITEM, &item, -1);
+    if (item == NULL || item->state != GPOINTER_TO_INT(data)) {
+        return FALSE;
+    }
+    return item->state == 1 || list_filter_item_visible (item - Xdialog.array);
+}
+#endif
+
+/* Moves the selected items (or all of them with BUILDLIST_ALL) to the other
+ * list: with GTK+ 2 and 3 their state is changed, then both views are
+ * refiltered at once with their models detached, the items keeping their
+ * order in both lists.
+ */
 void buildlist_add_or_remove (GtkButton *button, gpointer data)
 {
-    intptr_t remove = GPOINTER_TO_INT(data);
+    gint flags = GPOINTER_TO_INT(data);
     GtkWidget *listsrc;
     GtkWidget *listdest;
-    if (remove) {
+    if (flags & BUILDLIST_REMOVE) {
         listsrc  = Xdialog.widget2;
         listdest = Xdialog.widget1;
     } else {
@@ -1083,30 +2003,58 @@ void buildlist_add_or_remove (GtkButton *button, gpointer data)
         listdest = Xdialog.widget2;
     }
 #if GTK_CHECK_VERSION(2,0,0)
-    GtkTreeIter itersrc, iterdest;
     GtkTreeModel *modelsrc, *modeldest;
-    GtkTreeSelection* selection;
+    GtkTreeSelection *selection;
+    GtkTreeIter iter;
+    GList *rows, *row;
     listname *rowdata;
+    gint state = (flags & BUILDLIST_REMOVE) ? 0 : 1;
+    gboolean valid;
 
     modelsrc  = gtk_tree_view_get_model (GTK_TREE_VIEW(listsrc));
-    selection = gtk_tree_view_get_selection (GTK_TREE_VIEW(listsrc));
     modeldest = gtk_tree_view_get_model (GTK_TREE_VIEW(listdest));
 
-    if (gtk_tree_selection_get_selected(selection, &modelsrc, &itersrc))
-    {
-        gtk_tree_model_get (modelsrc, &itersrc,
-                            1, &rowdata, -1);
-        gtk_list_store_remove (GTK_LIST_STORE(modelsrc), &itersrc);
-        //--
-        gtk_list_store_append (GTK_LIST_STORE(modeldest), &iterdest);
-        gtk_list_store_set (GTK_LIST_STORE(modeldest), &iterdest,
-                            0, rowdata->name,
-                            1, rowdata,
-                            -1);
+    if (flags & BUILDLIST_ALL) {
+        /* all the listed items, i.e. those matching the --filter text */
+        valid = gtk_tree_model_get_iter_first (modelsrc, &iter);
+        while (valid) {
+            gtk_tree_model_get (modelsrc, &iter, BUILDLIST_COL_ITEM, &rowdata, -1);
+            rowdata->state = state;
+            valid = gtk_tree_model_iter_next (modelsrc, &iter);
+        }
+    } else {
+        selection = gtk_tree_view_get_selection (GTK_TREE_VIEW(listsrc));
+        rows = gtk_tree_selection_get_selected_rows (selection, NULL);
+        if (rows == NULL) {
+            return;
+        }
+        for (row = rows; row != NULL; row = row->next) {
+            if (gtk_tree_model_get_iter (modelsrc, &iter, (GtkTreePath *) row->data)) {
+                gtk_tree_model_get (modelsrc, &iter, BUILDLIST_COL_ITEM, &rowdata, -1);
+                rowdata->state = state;
+            }
+            gtk_tree_path_free ((GtkTreePath *) row->data);
+        }
+        g_list_free (rows);
     }
+
+    g_object_ref (G_OBJECT(modelsrc));
+    g_object_ref (G_OBJECT(modeldest));
+    gtk_tree_view_set_model (GTK_TREE_VIEW(listsrc), NULL);
+    gtk_tree_view_set_model (GTK_TREE_VIEW(listdest), NULL);
+    gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER(modelsrc));
+    gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER(modeldest));
+    gtk_tree_view_set_model (GTK_TREE_VIEW(listsrc), modelsrc);
+    gtk_tree_view_set_model (GTK_TREE_VIEW(listdest), modeldest);
+    g_object_unref (G_OBJECT(modelsrc));
+    g_object_unref (G_OBJECT(modeldest));
 #else // -- GTK1 --
     GList *selected;
-    selected = g_list_copy (GTK_LIST(listsrc)->selection);
+    if (flags & BUILDLIST_ALL) {
+        selected = g_list_copy (GTK_LIST(listsrc)->children);
+    } else {
+        selected = g_list_copy (GTK_LIST(listsrc)->selection);
+    }
     gtk_list_remove_items_no_unref (GTK_LIST(listsrc), selected);
     gtk_list_append_items (GTK_LIST(listdest), selected);
 #endif
@@ -1116,41 +2064,32 @@ void buildlist_add_or_remove (GtkButton *button, gpointer data)
 
 void buildlist_print_list (GtkButton *button, gpointer data)
 {
-    gboolean flag = FALSE;
     listname *rowdata;
 #if GTK_CHECK_VERSION(2,0,0)
     GtkTreeModel *model;
     GtkTreeIter iter;
     gboolean valid;
+    result_begin();
     model = gtk_tree_view_get_model (GTK_TREE_VIEW(Xdialog.widget2));
     valid = gtk_tree_model_get_iter_first(model, &iter);
     while (valid)
     {
         gtk_tree_model_get (model, &iter,
-                            1, &rowdata, -1);
-        if (flag) {
-            fprintf(Xdialog.output, "%s", Xdialog.separator);
-        }
-        fprintf (Xdialog.output, "%s", rowdata->tag);
-        flag = TRUE;
+                            BUILDLIST_COL_ITEM, &rowdata, -1);
+        result_add(item_tag(rowdata));
         valid = gtk_tree_model_iter_next (model, &iter);
     }
 #else // -- GTK1 --
     GList *children = GTK_LIST(Xdialog.widget2)->children;
+    result_begin();
     while (children)
     { // children->data = GtkListItem
         rowdata = (listname*) g_object_get_data (G_OBJECT(children->data), "listitem");
-        if (flag) {
-            fprintf(Xdialog.output, "%s", Xdialog.separator);
-        }
-        fprintf(Xdialog.output, "%s", rowdata->tag);
-        flag = TRUE;
+        result_add(item_tag(rowdata));
         children = g_list_next (children);
     }
 #endif
-    if (flag) {
-        fprintf(Xdialog.output, "\n");
-    }
+    result_end();
 }
 
 /* fselect callback */
@@ -1159,12 +2098,11 @@ gboolean filesel_exit(GtkWidget *filesel, gpointer client_data)
 #if GTK_CHECK_VERSION(2,4,0)
     char *filename = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (client_data));
     if (filename) {
-        fprintf(Xdialog.output, "%s\n", filename);
+        result_print(filename);
         g_free (filename);
     }
 #else
-    fprintf (Xdialog.output, "%s\n",
-             gtk_file_selection_get_filename (GTK_FILE_SELECTION(client_data)));
+    result_print(gtk_file_selection_get_filename (GTK_FILE_SELECTION(client_data)));
 #endif
     return exit_ok(NULL, NULL);
 }
@@ -1176,7 +2114,7 @@ gboolean colorsel_exit(GtkWidget *colorsel, gpointer client_data)
 #if GTK_CHECK_VERSION(3,4,0)
     GdkRGBA color;
     gtk_color_chooser_get_rgba (GTK_COLOR_CHOOSER(client_data), &color);
-    fprintf (Xdialog.output, "%d %d %d\n",
+    result_print_printf ("%d %d %d",
              (int) (color.red   * 256),
              (int) (color.green * 256),
              (int) (color.blue  * 256));
@@ -1184,14 +2122,14 @@ gboolean colorsel_exit(GtkWidget *colorsel, gpointer client_data)
     GdkColor color;
     gtk_color_selection_get_current_color (GTK_COLOR_SELECTION(client_data),
                                            &color);
-    fprintf (Xdialog.output, "%d %d %d\n",
+    result_print_printf ("%d %d %d",
              color.red   / 256,
              color.green / 256,
              color.blue  / 256);
 #else // -- GTK1 --
     double color[4];
     gtk_color_selection_get_color (GTK_COLOR_SELECTION(client_data), color);
-    fprintf (Xdialog.output, "%d %d %d\n",
+    result_print_printf ("%d %d %d",
              (int) (color[0] * 256),
              (int) (color[1] * 256),
              (int) (color[2] * 256));
@@ -1211,7 +2149,7 @@ gboolean fontsel_exit(GtkWidget *fontsel, gpointer client_data)
     font = gtk_font_selection_dialog_get_font_name (GTK_FONT_SELECTION_DIALOG(client_data));
 #endif
     if (font) {
-        fprintf(Xdialog.output, "%s\n", font);
+        result_print(font);
         g_free (font);
     }
     return exit_ok(NULL, NULL);
@@ -1223,7 +2161,7 @@ gboolean calendar_exit(gpointer object, gpointer data)
 {
     guint day, month, year;
     gtk_calendar_get_date(GTK_CALENDAR(Xdialog.widget1), &year, &month, &day);
-    fprintf(Xdialog.output, "%02d/%02d/%d\n", day, month+1, year);
+    result_print_printf("%02d/%02d/%d", day, month+1, year);
 
     return TRUE;
 }
@@ -1237,7 +2175,7 @@ gboolean calendar_timeout(gpointer data)
 
 gboolean timebox_exit(gpointer object, gpointer data)
 {
-    fprintf (Xdialog.output, "%02d:%02d:%02d\n",
+    result_print_printf ("%02d:%02d:%02d",
             gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(Xdialog.widget1)),
             gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(Xdialog.widget2)),
             gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(Xdialog.widget3)));
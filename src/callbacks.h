@@ -3,6 +3,12 @@ gboolean delete_event(gpointer object, GdkEventAny *event, gpointer data);
 
 gboolean destroy_event(gpointer object, GdkEventAny *event, gpointer data);
 
+void close_window(void);
+
+GtkWidget *take_spare_window(void);
+
+void drop_spare_window(void);
+
 gint double_click_event(GtkWidget *object, GdkEventButton *event, gpointer data);
 
 gboolean exit_ok(gpointer object, gpointer data);
@@ -35,6 +41,27 @@ gboolean logbox_timeout(gpointer data);
 
 gboolean inputbox_ok(gpointer object, gpointer data);
 
+#if GTK_CHECK_VERSION(2,4,0)
+void combo_index_init (gint list_size);
+void combo_index_free (void);
+void combo_entry_changed (GtkEditable *editable, gpointer data);
+gboolean combo_completion_match (GtkEntryCompletion *completion, const gchar *key,
+                                 GtkTreeIter *iter, gpointer data);
+#endif
+#if GTK_CHECK_VERSION(2,16,0)
+void combo_icon_press (GtkEntry *entry, GtkEntryIconPosition position,
+                       GdkEvent *event, gpointer data);
+void combo_popup_activated (GtkTreeView *treeview, GtkTreePath *path,
+                            GtkTreeViewColumn *column, gpointer data);
+gboolean combo_popup_click (GtkWidget *widget, GdkEventButton *event, gpointer data);
+gboolean combo_popup_keypress (GtkWidget *popup, GdkEventKey *event, gpointer data);
+gboolean combo_popup_focus_out (GtkWidget *popup, GdkEventFocus *event, gpointer data);
+#endif
+gboolean interval_report(gpointer data);
+void report_changes_init(GSourceFunc printer);
+void report_changes_free(void);
+void report_changed(gpointer object, gpointer data);
+
 gboolean input_keypress(GtkWidget *entry, GdkEventKey *event, gpointer data);
 
 gboolean inputbox_timeout(gpointer data);
@@ -58,6 +85,22 @@ void item_toggle(GtkWidget *item, int i);
 gboolean print_items(GtkButton *button, gpointer data);
 
 gboolean itemlist_timeout(gpointer data);
+#if GTK_CHECK_VERSION(2,0,0)
+void itemlist_toggled (GtkCellRendererToggle *cell, gchar *path_string, gpointer data);
+void itemlist_row_activated (GtkTreeView *tree_view, GtkTreePath *path,
+                             GtkTreeViewColumn *column, gpointer data);
+gboolean itemlist_query_tooltip (GtkWidget *widget, gint x, gint y, gboolean keyboard_mode,
+                                 GtkTooltip *tooltip, gpointer data);
+#endif
+
+#if GTK_CHECK_VERSION(2,0,0)
+void list_filter_init (gint list_size, gint column);
+void list_filter_free (void);
+void list_filter_add (gint i);
+gboolean list_filter_item_visible (gint i);
+gboolean list_filter_visible (GtkTreeModel *model, GtkTreeIter *iter, gpointer data);
+void list_filter_changed (GtkEditable *editable, gpointer data);
+#endif
 
 void on_menubox_ok_click (GtkButton *button, gpointer data);
 #if GTK_CHECK_VERSION(2,0,0)
@@ -71,9 +114,17 @@ gboolean move_to_row_timeout(gpointer data);
 #endif
 
 void print_tree_selection (GtkButton *button, gpointer data);
+#if GTK_CHECK_VERSION(2,0,0)
+void tree_add_children (GtkTreeStore *store, GtkTreeIter *parent, gint first);
+gboolean tree_test_expand_row (GtkTreeView *treeview, GtkTreeIter *iter,
+                               GtkTreePath *path, gpointer data);
+#endif
 void tree_selection_changed (GtkWidget *tree);
 
 void buildlist_sensitive_buttons(void);
+#if GTK_CHECK_VERSION(2,0,0)
+gboolean buildlist_row_visible (GtkTreeModel *model, GtkTreeIter *iter, gpointer data);
+#endif
 void buildlist_add_or_remove (GtkButton *button, gpointer data);
 void buildlist_print_list (GtkButton *button, gpointer data);
 
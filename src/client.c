@@ -0,0 +1,236 @@
+/*
+ * Xdialog-client: thin client for an Xdialog dialog server.
+ *
+ * Usage: Xdialog-client <Xdialog options>
+ *
+ * The command line, the current directory, the environment variables which
+ * apply to the dialog and the stdin, stdout and stderr descriptors (plus the
+ * ones given to --output-fd and --control-fd) are passed to the server
+ * listening on the UNIX socket given by the XDIALOG_SERVER environment
+ * variable (see "Xdialog --server"), and the client exits with the dialog
+ * exit code.  When no server can be reached, Xdialog is run instead.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "server.h"
+
+#define CLIENT "Xdialog-client"
+
+static int server_connect(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (path == NULL || *path == '\0' || strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int write_all(int fd, const char *buffer, size_t length)
+{
+    ssize_t n;
+
+    while (length > 0) {
+        n = write(fd, buffer, length);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        buffer += n;
+        length -= n;
+    }
+    return 0;
+}
+
+/* Collects the descriptors given to the SERVER_FD_OPTIONS options, for the
+ * server to use them in place of its own, returning their count.
+ */
+static unsigned int option_fds(int argc, char *argv[], int fds[SERVER_MAX_FDS])
+{
+    static const char *options[] = SERVER_FD_OPTIONS;
+    const char *value;
+    unsigned int nfds = 0, j;
+    size_t len;
+    char *end;
+    long n;
+    int i, k;
+
+    for (i = 1; i < argc; i++) {
+        for (k = 0; options[k] != NULL; k++) {
+            len = strlen(options[k]);
+            if (strncmp(argv[i], options[k], len) != 0)
+                continue;
+            if (argv[i][len] == '=')
+                value = argv[i] + len + 1;
+            else if (argv[i][len] == '\0' && i + 1 < argc)
+                value = argv[i + 1];
+            else
+                continue;
+            n = strtol(value, &end, 10);
+            if (*value == '\0' || *end != '\0' || n <= 2 || n > INT_MAX ||
+                fcntl((int) n, F_GETFD) < 0)
+                continue;    /* the server reports it */
+            for (j = 0; j < nfds && fds[j] != n; j++)
+                ;
+            if (j == nfds && nfds < SERVER_MAX_FDS)
+                fds[nfds++] = (int) n;
+        }
+    }
+    return nfds;
+}
+
+/* Collects the SERVER_ENV variables which are set, returning their count */
+static unsigned int request_env(char *env[])
+{
+    static const char *names[] = SERVER_ENV;
+    unsigned int nenv = 0;
+    size_t len;
+    char *value;
+    int i;
+
+    for (i = 0; names[i] != NULL; i++) {
+        if ((value = getenv(names[i])) == NULL)
+            continue;
+        len = strlen(names[i]);
+        env[nenv] = malloc(len + strlen(value) + 2);
+        if (env[nenv] == NULL)
+            continue;
+        sprintf(env[nenv++], "%s=%s", names[i], value);
+    }
+    return nenv;
+}
+
+static int send_request(int fd, int argc, char *argv[])
+{
+    server_request request;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union {
+        struct cmsghdr align;
+        char buffer[CMSG_SPACE((3 + SERVER_MAX_FDS) * sizeof(int))];
+    } control;
+    int fds[3 + SERVER_MAX_FDS] = { 0, 1, 2 };
+    static const char *names[] = SERVER_ENV;
+    char *env[sizeof(names) / sizeof(names[0])];
+    char cwd[PATH_MAX], *payload;
+    unsigned int nenv, j;
+    size_t length, len;
+    int i, ret;
+
+    if (getcwd(cwd, sizeof(cwd)) == NULL)
+        cwd[0] = '\0';    /* the server will stay in its own directory */
+    nenv = request_env(env);
+    length = strlen(cwd) + 1;
+    for (i = 0; i < argc; i++)
+        length += strlen(argv[i]) + 1;
+    for (j = 0; j < nenv; j++)
+        length += strlen(env[j]) + 1;
+    if (length > SERVER_MAX_REQUEST || (payload = malloc(length)) == NULL) {
+        for (j = 0; j < nenv; j++)
+            free(env[j]);
+        return -1;
+    }
+    len = strlen(cwd) + 1;
+    memcpy(payload, cwd, len);
+    length = len;
+    for (i = 0; i < argc; i++) {
+        len = strlen(argv[i]) + 1;
+        memcpy(payload + length, argv[i], len);
+        length += len;
+    }
+    for (j = 0; j < nenv; j++) {
+        len = strlen(env[j]) + 1;
+        memcpy(payload + length, env[j], len);
+        length += len;
+        free(env[j]);
+    }
+
+    memset(&request, 0, sizeof(request));
+    memcpy(request.magic, SERVER_MAGIC, 4);
+    request.argc = argc;
+    request.nenv = nenv;
+    request.nfds = option_fds(argc, argv, request.fds);
+    memcpy(fds + 3, request.fds, request.nfds * sizeof(int));
+    request.length = length;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&control, 0, sizeof(control));
+    iov.iov_base = &request;
+    iov.iov_len = sizeof(request);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = CMSG_SPACE((3 + request.nfds) * sizeof(int));
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN((3 + request.nfds) * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, (3 + request.nfds) * sizeof(int));
+
+    do
+        ret = sendmsg(fd, &msg, 0);
+    while (ret < 0 && errno == EINTR);
+    if (ret != (int) sizeof(request) || write_all(fd, payload, length) != 0)
+        ret = -1;
+    else
+        ret = 0;
+
+    free(payload);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    int fd, status;
+    ssize_t n;
+
+    fd = server_connect(getenv(SERVER_SOCKET));
+    if (fd < 0) {
+        /* No server: do the job ourselves */
+        argv[0] = SERVER_FALLBACK;
+        execvp(SERVER_FALLBACK, argv);
+        fprintf(stderr, CLIENT": can't run "SERVER_FALLBACK": %s\n",
+                strerror(errno));
+        return 255;
+    }
+
+    argv[0] = SERVER_FALLBACK;
+    if (send_request(fd, argc, argv) != 0) {
+        fprintf(stderr, CLIENT": can't send the request: %s\n", strerror(errno));
+        return 255;
+    }
+
+    do
+        n = read(fd, &status, sizeof(status));
+    while (n < 0 && errno == EINTR);
+    if (n != sizeof(status))
+        return 255;
+
+    return status;
+}
@@ -0,0 +1,384 @@
+/*
+ * Control channel for Xdialog (--control-fd <fd>).
+ *
+ * The dialog being shown is updated from commands read on a file descriptor,
+ * one per line, with their arguments quoted as in a shell:
+ *
+ *   title TEXT                  sets the window title,
+ *   label TEXT                  sets the box label ("\n" for a linefeed),
+ *   progress PERCENT            sets the gauge or progress bar value,
+ *   add TAG ITEM [STATUS [TIP]] appends an item to a checklist or radiolist,
+ *   remove TAG                  removes an item from it,
+ *   state TAG on|off            checks or unchecks an item,
+ *   sensitive BUTTON on|off     (un)greys a button (ok, cancel, extra, help,
+ *                               previous or print),
+ *   click BUTTON                acts as if the button was pressed,
+ *   close [EXIT_CODE]           closes the dialog (exit code 0 by default).
+ *
+ * The descriptor is read as data comes in (a command may span several
+ * reads) and the complete lines are queued.  The queued commands are then
+ * applied in a single batch from an idle callback run before the next
+ * relayout and redraw, so that a burst of updates costs one frame only.
+ * Commands received while no dialog is shown (e.g. between chained boxes)
+ * wait for the next one, but not for the next command line (script mode) or
+ * request (server mode): see control_close().
+ */
+
+#include "common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+
+#include "interface.h"
+#include "callbacks.h"
+#include "support.h"
+#include "server.h"
+
+/* Global structures and variables */
+extern Xdialog_data Xdialog;
+
+#define CONTROL_READ_SIZE 4096
+
+static GIOChannel *channel  = NULL;
+static gint        channel_fd = -1;    /* option value (client number) */
+static gint        channel_flags;      /* descriptor flags to restore */
+static guint       watch    = 0;
+static guint       idle     = 0;
+static GString    *partial  = NULL;    /* line being received */
+static GPtrArray  *pending  = NULL;    /* complete lines, to be applied */
+
+static const gchar *button_names[] = {
+    "ok", "cancel", "help", "previous", "print", "extra", NULL
+};
+
+/* Returns the button named "name" (see set_button()), or NULL */
+static GtkWidget *control_button(const gchar *name)
+{
+    gint i;
+
+    for (i = 0; button_names[i] != NULL; i++) {
+        if (strcmp(name, button_names[i]) == 0)
+            return g_object_get_data(G_OBJECT(Xdialog.vbox), button_names[i]);
+    }
+    return NULL;
+}
+
+static gboolean control_switch(const gchar *value, gboolean *on)
+{
+    if (strcasecmp(value, "on") == 0)
+        *on = TRUE;
+    else if (strcasecmp(value, "off") == 0)
+        *on = FALSE;
+    else
+        return FALSE;
+    return TRUE;
+}
+
+static void control_progress(const gchar *percent)
+{
+    GtkWidget *pbar = g_object_get_data(G_OBJECT(Xdialog.vbox), "progress_bar");
+    gdouble value = CLAMP(g_ascii_strtod(percent, NULL), 0, 100);
+
+    if (pbar == NULL)
+        return;
+#if GTK_CHECK_VERSION(2,0,0)
+    char txt[20];
+    snprintf(txt, sizeof(txt), "%g%%", value);
+    gtk_progress_bar_set_text (GTK_PROGRESS_BAR(pbar), txt);
+    gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR(pbar), value / 100);
+#else // -- GTK1 --
+    gtk_progress_set_percentage (GTK_PROGRESS(pbar), value / 100);
+#endif
+}
+
+#if GTK_CHECK_VERSION(2,0,0)
+
+/* The checklist/radiolist rows only hold the item indices (see
+ * create_itemlist()): items are appended to Xdialog.array and to the list
+ * store, underneath the --filter model, if any.
+ */
+static GtkListStore *itemlist_store(void)
+{
+    GtkTreeModel *model;
+
+    if (Xdialog.widget1 == NULL ||
+        g_object_get_data(G_OBJECT(Xdialog.widget1), "list_type") == NULL)
+        return NULL;
+    model = gtk_tree_view_get_model(GTK_TREE_VIEW(Xdialog.widget1));
+    if (GTK_IS_TREE_MODEL_FILTER(model))
+        model = gtk_tree_model_filter_get_model(GTK_TREE_MODEL_FILTER(model));
+    return GTK_LIST_STORE(model);
+}
+
+static void itemlist_set_state(gint i, gboolean on)
+{
+    gint radio_item;
+
+    if (GPOINTER_TO_INT(g_object_get_data(G_OBJECT(Xdialog.widget1),
+                                          "list_type")) == RADIOLIST) {
+        if (!on)
+            return;
+        radio_item = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(Xdialog.widget1),
+                                                       "radio_item"));
+        Xdialog.array[radio_item].state = 0;
+        g_object_set_data(G_OBJECT(Xdialog.widget1), "radio_item", GINT_TO_POINTER(i));
+    }
+    Xdialog.array[i].state = on;
+}
+
+static gboolean control_add(GtkListStore *store, gchar **args, gint n)
+{
+    gchar *status = n > 3 ? args[3] : "off";
+    gboolean on = strcasecmp(status, "on") == 0 && *args[1] != '\0';
+    gint i;
+
+    if (n < 3 || n > 5)
+        return FALSE;
+    i = add_list_item(args[1], args[2], n > 4 ? args[4] : NULL);
+    list_filter_add(i);
+    gtk_list_store_insert_with_values(store, NULL, -1,
+                                      ITEMLIST_COL_INDEX, i,
+                                      ITEMLIST_COL_SENSITIVE,
+                                      strcasecmp(status, "unavailable") != 0 &&
+                                      *args[1] != '\0',
+                                      -1);
+    if (on)
+        itemlist_set_state(i, TRUE);
+    return TRUE;
+}
+
+/* Removes the rows of the items held by "removed" in a single pass */
+static void itemlist_remove(GtkListStore *store, GHashTable *removed)
+{
+    GtkTreeModel *model = GTK_TREE_MODEL(store);
+    GtkTreeIter iter;
+    gboolean valid;
+    gint i;
+
+    valid = gtk_tree_model_get_iter_first(model, &iter);
+    while (valid) {
+        gtk_tree_model_get(model, &iter, ITEMLIST_COL_INDEX, &i, -1);
+        if (g_hash_table_lookup(removed, GINT_TO_POINTER(i + 1)) != NULL)
+            valid = gtk_list_store_remove(store, &iter);
+        else
+            valid = gtk_tree_model_iter_next(model, &iter);
+    }
+}
+
+#endif
+
+/* Applies a command line, returning FALSE if it is not understood */
+static gboolean control_command(gchar **args, gint n, GHashTable *removed,
+                                gboolean *list_changed)
+{
+    GtkWidget *widget;
+    gchar *text;
+    gboolean on;
+#if GTK_CHECK_VERSION(2,0,0)
+    GtkListStore *store = itemlist_store();
+    gint i;
+#endif
+
+    if (strcmp(args[0], "title") == 0 && n == 2) {
+        gtk_window_set_title(GTK_WINDOW(Xdialog.window), args[1]);
+    } else if (strcmp(args[0], "label") == 0 && n == 2) {
+        widget = g_object_get_data(G_OBJECT(Xdialog.vbox), "label");
+        if (widget != NULL) {
+            text = backslash_n_to_linefeed(args[1]);
+            gtk_label_set_text(GTK_LABEL(widget), text);
+            g_free(text);
+        }
+    } else if (strcmp(args[0], "progress") == 0 && n == 2) {
+        control_progress(args[1]);
+    } else if (strcmp(args[0], "sensitive") == 0 && n == 3) {
+        if (!control_switch(args[2], &on))
+            return FALSE;
+        if ((widget = control_button(args[1])) != NULL)
+            gtk_widget_set_sensitive(widget, on);
+    } else if (strcmp(args[0], "click") == 0 && n == 2) {
+        if ((widget = control_button(args[1])) != NULL)
+            gtk_button_clicked(GTK_BUTTON(widget));
+    } else if (strcmp(args[0], "close") == 0 && n <= 2) {
+        Xdialog.exit_code = n == 2 ? atoi(args[1]) : 0;
+        close_window();
+#if GTK_CHECK_VERSION(2,0,0)
+    } else if (strcmp(args[0], "add") == 0) {
+        if (store == NULL)
+            return TRUE;
+        if (!control_add(store, args, n))
+            return FALSE;
+        *list_changed = TRUE;
+    } else if (strcmp(args[0], "remove") == 0 && n == 2) {
+        if (store == NULL || (i = find_list_item(args[1])) < 0)
+            return TRUE;
+        /* The array slot stays, cleared so that the tag is no longer found,
+         * and the row goes with the others at the end of the batch */
+        set_list_item(i, "", "", NULL);
+        g_hash_table_insert(removed, GINT_TO_POINTER(i + 1), GINT_TO_POINTER(i + 1));
+        *list_changed = TRUE;
+    } else if (strcmp(args[0], "state") == 0 && n == 3) {
+        if (!control_switch(args[2], &on))
+            return FALSE;
+        if (store == NULL || (i = find_list_item(args[1])) < 0)
+            return TRUE;
+        itemlist_set_state(i, on);
+        *list_changed = TRUE;
+#endif
+    } else {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Idle callback: applies the queued commands to the current dialog */
+static gboolean control_apply(gpointer data)
+{
+    GHashTable *removed = g_hash_table_new(NULL, NULL);
+    gboolean list_changed = FALSE;
+    GError *error = NULL;
+    gchar **args;
+    gint n;
+    guint i;
+
+    idle = 0;
+    for (i = 0; i < pending->len && Xdialog.window != NULL; i++) {
+        if (!g_shell_parse_argv(g_ptr_array_index(pending, i), &n, &args, &error)) {
+            if (error->code != G_SHELL_ERROR_EMPTY_STRING)
+                fprintf(stderr, XDIALOG": control: %s\n", error->message);
+            g_clear_error(&error);
+            continue;
+        }
+        if (!control_command(args, n, removed, &list_changed))
+            fprintf(stderr, XDIALOG": control: bad command: %s\n",
+                    (gchar *) g_ptr_array_index(pending, i));
+        g_strfreev(args);
+    }
+    /* Lines left over by a "close" go to the next dialog */
+    g_ptr_array_remove_range(pending, 0, i);
+
+#if GTK_CHECK_VERSION(2,0,0)
+    if (Xdialog.window != NULL && list_changed) {
+        if (g_hash_table_size(removed) > 0)
+            itemlist_remove(itemlist_store(), removed);
+        gtk_widget_queue_draw(Xdialog.widget1);
+        report_changed(NULL, NULL);
+    }
+#endif
+    g_hash_table_destroy(removed);
+    return FALSE;
+}
+
+/* Queues the complete lines of the data received (the last one being kept
+ * until its end comes in) and schedules a batch if a dialog is shown.
+ */
+static void control_queue(const gchar *buffer, gsize length)
+{
+    const gchar *end;
+    gsize i, n;
+
+    for (i = 0; i < length; i += n + 1) {
+        end = memchr(buffer + i, '\n', length - i);
+        n = (end != NULL ? end : buffer + length) - (buffer + i);
+        g_string_append_len(partial, buffer + i, n);
+        if (end == NULL)
+            break;
+        g_ptr_array_add(pending, g_strndup(partial->str, partial->len));
+        g_string_truncate(partial, 0);
+    }
+    control_start();
+}
+
+static gboolean control_read(GIOChannel *source, GIOCondition condition, gpointer data)
+{
+    gchar buffer[CONTROL_READ_SIZE];
+    ssize_t length;
+
+    /* Read all what is available, one read at least (on hang up, the
+     * remaining data is read until EOF) */
+    for (;;) {
+        length = read(g_io_channel_unix_get_fd(source), buffer, sizeof(buffer));
+        if (length > 0) {
+            control_queue(buffer, length);
+            continue;
+        }
+        if (length < 0 && errno == EINTR)
+            continue;
+        if (length < 0 && errno == EAGAIN)
+            return TRUE;
+        break;
+    }
+    /* EOF or error: the last line may lack its linefeed */
+    if (partial->len > 0)
+        control_queue("\n", 1);
+    watch = 0;
+    return FALSE;
+}
+
+/* Schedules the queued commands for the dialog being shown (called for each
+ * new dialog, as commands may have come while there was none).
+ */
+void control_start(void)
+{
+    if (pending != NULL && pending->len > 0 && idle == 0 && Xdialog.window != NULL)
+        idle = g_idle_add_full(G_PRIORITY_HIGH_IDLE, control_apply, NULL, NULL);
+}
+
+/* Starts reading the commands from the "fd" descriptor (--control-fd).  In
+ * server mode, the descriptor is the one passed by the client for "fd".
+ */
+void control_open(const gchar *fd)
+{
+    gchar *end;
+    long n = strtol(fd, &end, 10);
+    gint own = -1;
+
+    if (*fd != '\0' && *end == '\0' && n >= 0 && n <= G_MAXINT)
+        own = server_fd((int) n);
+    if (own < 0 || fcntl(own, F_GETFL) < 0) {
+        fprintf(stderr, XDIALOG": bad control file descriptor: %s%s\n", fd,
+                own < 0 && n > 2 ? " (not passed by the client, use "
+                                   "--control-fd in full)" : "");
+        xdialog_exit(255);
+    }
+    if (channel != NULL && channel_fd == n)
+        return;    /* same channel for the next dialog of the command line */
+    control_close();
+
+    partial = g_string_sized_new(256);
+    pending = g_ptr_array_new_with_free_func(g_free);
+    channel_fd    = (gint) n;
+    channel_flags = fcntl(own, F_GETFL);
+    fcntl(own, F_SETFL, channel_flags | O_NONBLOCK);
+    channel = g_io_channel_unix_new(own);
+    watch   = g_io_add_watch(channel, G_IO_IN | G_IO_ERR | G_IO_HUP,
+                             control_read, NULL);
+}
+
+/* Stops reading the control descriptor and drops the commands not applied
+ * yet, at the end of a command line (script mode) or request (server mode,
+ * before the client descriptors are closed).  The descriptor flags are
+ * restored, as they are shared with the process that gave it.
+ */
+void control_close(void)
+{
+    if (watch != 0) {
+        g_source_remove(watch);
+        watch = 0;
+    }
+    if (idle != 0) {
+        g_source_remove(idle);
+        idle = 0;
+    }
+    if (channel != NULL) {
+        fcntl(g_io_channel_unix_get_fd(channel), F_SETFL, channel_flags);
+        g_io_channel_unref(channel);
+        channel = NULL;
+        channel_fd = -1;
+    }
+    if (pending != NULL) {
+        g_ptr_array_free(pending, TRUE);
+        g_string_free(partial, TRUE);
+        pending = NULL;
+        partial = NULL;
+    }
+}
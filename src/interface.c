@@ -24,35 +24,177 @@ static gint ymult = YSIZE_MULT;
 static gint ffxmult = XSIZE_MULT;
 static gint ffymult = YSIZE_MULT;
 
-/* Parsing of the GTK+ rc file (if any) */
+/* Parsing of the GTK+ rc file (if any).  The parsed styles add up for the
+ * process lifetime (--script, --server), so that the same ones are not
+ * parsed again.
+ */
 
 static void parse_rc_file(void)
 {
-    if (strlen(Xdialog.rc_file) != 0)
+    static gchar *parsed_rc_file = NULL;
+    static gboolean fixed_font_parsed = FALSE;
+
+    trace_begin("parse_rc_file");
+    if (strlen(Xdialog.rc_file) != 0 &&
+        (parsed_rc_file == NULL || strcmp(parsed_rc_file, Xdialog.rc_file) != 0)) {
         gtk_rc_parse(Xdialog.rc_file);
-    if (dialog_compat)
+        g_free(parsed_rc_file);
+        parsed_rc_file = g_strdup(Xdialog.rc_file);
+    }
+    if (dialog_compat && !fixed_font_parsed) {
         gtk_rc_parse_string(FIXED_FONT_RC_STRING);
+        fixed_font_parsed = TRUE;
+    }
+    trace_end("parse_rc_file");
 }
 
+#if GTK_CHECK_VERSION(2,0,0)
+/* Average character width and line height (in pixels) of a font, measured
+ * off-screen on the default Pango context (no window needs to be realized).
+ * As this is done at each Xdialog launch, the results are cached on disk,
+ * keyed by the font description and the screen resolution.
+ */
+
+static void font_metrics(GKeyFile *cache, gboolean *cache_changed,
+                         PangoFontDescription *font_desc,
+                         gint *width, gint *height)
+{
+    static PangoContext *context = NULL;
+    PangoLayout *layout;
+    gchar *font_name, *group;
+    gint w, h;
+    gdouble dpi = -1;
+
+#if GTK_CHECK_VERSION(2,10,0)
+    dpi = gdk_screen_get_resolution(gdk_screen_get_default());
+#endif
+    font_name = pango_font_description_to_string(font_desc);
+    group = g_strdup_printf("%s@%g", font_name, dpi);
+    g_free(font_name);
+
+    if (cache != NULL && g_key_file_has_group(cache, group)) {
+        w = g_key_file_get_integer(cache, group, "width", NULL);
+        h = g_key_file_get_integer(cache, group, "height", NULL);
+        if (w > 0 && h > 0) {
+            *width = w;
+            *height = h;
+            g_free(group);
+            return;
+        }
+    }
+
+    if (context == NULL)
+        context = gdk_pango_context_get();
+    layout = pango_layout_new(context);
+    pango_layout_set_font_description(layout, font_desc);
+    pango_layout_set_text(layout, ALPHANUM_CHARS, -1);
+    pango_layout_get_pixel_size(layout, &w, &h);
+    g_object_unref(layout);
+
+    /* For proportionnal fonts, we use the average character width... */
+    if (w >= 62 && h > 0) {
+        *width = w / 62;		/* 62 = strlen(ALPHANUM_CHARS) */
+        *height = h + 2;		/*  2 = spacing pixel lines */
+        if (cache != NULL) {
+            g_key_file_set_integer(cache, group, "width", *width);
+            g_key_file_set_integer(cache, group, "height", *height);
+            *cache_changed = TRUE;
+        }
+    }
+    g_free(group);
+}
+#endif
+
 /* font_init() is used for two purposes: load the fixed font that Xdialog may
  * use, and calculate the character size in pixels (both for the fixed font
  * and for the font currently in use: the later one may be a proportionnal
- * font and the character width is therefore an averaged value).
+ * font and the character width is therefore an averaged value).  This is
+ * done again only when the dialog compatibility mode changes (--script,
+ * --server).
  */
 
 static void font_init(void)
 {
+    static gint font_compat = -1;    /* dialog_compat of the metrics */
 #if GTK_CHECK_VERSION(2,0,0)
-    fixed_pango_font = pango_font_description_new ();
-    pango_font_description_set_family (fixed_pango_font, FIXED_FONT);
-    pango_font_description_set_weight (fixed_pango_font, PANGO_WEIGHT_MEDIUM);
-    pango_font_description_set_size (fixed_pango_font, 10 * PANGO_SCALE);
+    PangoFontDescription *font_desc = NULL;
+    GKeyFile *cache = NULL;
+    gboolean cache_changed = FALSE;
+    gchar *font_name = NULL, *cache_dir = NULL, *cache_file = NULL, *data;
+    gsize length;
+#if GTK_MAJOR_VERSION == 2
+    GtkStyle *style;
 #endif
-#if GTK_MAJOR_VERSION <= 2
+#else // -- GTK1 --
     GtkWidget *window;
     GtkStyle  *style;
     GdkFont *font;
     gint width, ascent, descent, lbearing, rbearing;
+#endif
+
+    if (font_compat == dialog_compat)
+        return;
+    font_compat = dialog_compat;
+    trace_begin("font_init");
+
+#if GTK_CHECK_VERSION(2,0,0)
+    if (fixed_pango_font == NULL) {
+        fixed_pango_font = pango_font_description_new ();
+        pango_font_description_set_family (fixed_pango_font, FIXED_FONT);
+        pango_font_description_set_weight (fixed_pango_font, PANGO_WEIGHT_MEDIUM);
+        pango_font_description_set_size (fixed_pango_font, 10 * PANGO_SCALE);
+    }
+
+#if GTK_CHECK_VERSION(2,10,0)
+    cache = g_key_file_new();
+    cache_dir = g_build_filename(g_get_user_cache_dir(), XDIALOG, NULL);
+    cache_file = g_build_filename(cache_dir, "font-metrics", NULL);
+    g_key_file_load_from_file(cache, cache_file, G_KEY_FILE_NONE, NULL);
+#endif
+
+    font_metrics(cache, &cache_changed, fixed_pango_font, &ffxmult, &ffymult);
+
+    if (dialog_compat) {
+        xmult = ffxmult;
+        ymult = ffymult;
+    } else {
+#if GTK_MAJOR_VERSION == 2
+        /* The theme font is the one of the rc style applying to windows */
+        parse_rc_file();
+        style = gtk_rc_get_style_by_paths(gtk_settings_get_default(),
+                                          "GtkWindow", "GtkWindow",
+                                          GTK_TYPE_WINDOW);
+        if (style != NULL && style->font_desc != NULL)
+            font_desc = pango_font_description_copy(style->font_desc);
+#endif
+        if (font_desc == NULL) {
+            g_object_get(gtk_settings_get_default(), "gtk-font-name",
+                         &font_name, NULL);
+            if (font_name != NULL)
+                font_desc = pango_font_description_from_string(font_name);
+            g_free(font_name);
+        }
+        if (font_desc != NULL) {
+            font_metrics(cache, &cache_changed, font_desc, &xmult, &ymult);
+            pango_font_description_free(font_desc);
+        } else {
+            xmult = ffxmult;
+            ymult = ffymult;
+        }
+    }
+
+    if (cache != NULL) {
+        if (cache_changed) {
+            data = g_key_file_to_data(cache, &length, NULL);
+            g_mkdir_with_parents(cache_dir, 0700);
+            g_file_set_contents(cache_file, data, length, NULL);
+            g_free(data);
+        }
+        g_key_file_free(cache);
+        g_free(cache_dir);
+        g_free(cache_file);
+    }
+#else // -- GTK1 --
     if (dialog_compat) {
         xmult = ffxmult;
         ymult = ffymult;
@@ -72,10 +214,8 @@ static void font_init(void)
         }
         gtk_widget_destroy(window);
     }
-#else
-    xmult = ffxmult;
-    ymult = ffymult;
 #endif
+    trace_end("font_init");
 }
 
 void get_maxsize(int *x, int *y)
@@ -88,12 +228,31 @@ void get_maxsize(int *x, int *y)
 
 /* Custom text wrapping (the GTK+ one is buggy) */
 
+#if GTK_CHECK_VERSION(2,0,0)
+/* Wrapped texts of the dialog being set up, keyed by their width and text,
+ * for the labels updated over and over (e.g. the gauge ones): forgotten for
+ * each dialog (see open_window()) and past WRAP_CACHE_SIZE texts.
+ */
+#define WRAP_CACHE_SIZE 64
+static GHashTable *wrap_cache = NULL;
+#endif
+
+#if GTK_MAJOR_VERSION == 1 // -- GTK1 --
+static int font_char_width(unsigned char c, void *font)
+{
+    return gdk_char_width((GdkFont *) font, c);
+}
+#endif
+
 static void wrap_text(gchar *str, gint reserved_width)
 {
-    gint max_line_width, n = 0;
-    gchar *p = str, *last_space = NULL;
-    gchar tmp[MAX_LABEL_LENGTH];
-#if GTK_MAJOR_VERSION <= 2
+    gint max_line_width;
+#if GTK_CHECK_VERSION(2,0,0)
+    PangoLayout *layout;
+    PangoLayoutIter *iter;
+    gchar *key, *wrapped;
+    gint index;
+#else // -- GTK1 --
     GdkFont *current_font = gtk_style_get_font(Xdialog.window->style);
 #endif
 
@@ -105,32 +264,55 @@ static void wrap_text(gchar *str, gint reserved_width)
         max_line_width =  gdk_screen_width() - reserved_width - 6 * xmult;
     }
 
-    do
-    {
-        if (*p == '\n') {
-            n = 0;
-            last_space = NULL;
-        } else {
-            tmp[n++] = *p;
-            tmp[n] = 0;
-#if GTK_MAJOR_VERSION <= 2
-            if (gdk_string_width(current_font, tmp) < max_line_width) {
-                if (*p == ' ')
-                    last_space = p;
-            } else {
-#endif
-                if (last_space != NULL) {
-                    *last_space = '\n';
-                    p = last_space;
-                    n = 0;
-                    last_space = NULL;
-                } else if (*p == ' ')
-                    last_space = p;
-#if GTK_MAJOR_VERSION <= 2
-            }
+#if GTK_CHECK_VERSION(2,0,0)
+    /* Lay the whole text out once with Pango and turn the spaces on which
+     * it broke the lines into linefeeds.  Results are cached, so that the
+     * same text is not measured again (e.g. when a dialog is re-shown). */
+    if (*str == '\0' || max_line_width <= 0 || !g_utf8_validate(str, -1, NULL))
+        return;
+
+    if (wrap_cache == NULL)
+        wrap_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                           g_free, g_free);
+    else if (g_hash_table_size(wrap_cache) >= WRAP_CACHE_SIZE)
+        g_hash_table_remove_all(wrap_cache);
+    key = g_strdup_printf("%d:%s", max_line_width, str);
+    wrapped = g_hash_table_lookup(wrap_cache, key);
+    if (wrapped != NULL) {
+        /* only spaces were changed, so the length is the same */
+        memcpy(str, wrapped, strlen(str));
+        g_free(key);
+        return;
+    }
+
+    layout = gtk_widget_create_pango_layout(Xdialog.window, str);
+    pango_layout_set_width(layout, max_line_width * PANGO_SCALE);
+    pango_layout_set_wrap(layout, PANGO_WRAP_WORD);
+
+    iter = pango_layout_get_iter(layout);
+    while (pango_layout_iter_next_line(iter)) {
+        index = pango_layout_iter_get_index(iter);
+        if (index > 0 && str[index-1] == ' ')
+            str[index-1] = '\n';
+    }
+    pango_layout_iter_free(iter);
+    g_object_unref(layout);
+
+    g_hash_table_insert(wrap_cache, key, g_strdup(str));
+#else // -- GTK1 --
+    /* Summed up character widths (see text.c), rather than measuring each
+     * line prefix again */
+    wrap_words(str, max_line_width, font_char_width, current_font);
 #endif
-        }
-    } while (++p < str + strlen(str));
+}
+
+/* (Re)initialize the label text buffer used by infobox, gauge and progress */
+
+static void reset_label_text(const gchar *text)
+{
+    if (Xdialog.label_text == NULL)
+        Xdialog.label_text = g_string_sized_new(256);
+    g_string_assign(Xdialog.label_text, text != NULL ? text : "");
 }
 
 /* Some useful functions to setup GTK menus... */
@@ -171,29 +353,44 @@ static void open_window(void)
     GtkWidget *vbox;
 
     font_init();
+#if GTK_CHECK_VERSION(2,0,0)
+    if (wrap_cache != NULL)
+        g_hash_table_remove_all(wrap_cache);
+#endif
 
-    /* Open a new GTK top-level window */
-    window = Xdialog.window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    /* Reuse the window of the previous dialog (--script), if any */
+    window = Xdialog.window = take_spare_window();
 
-    /* Apply the custom GTK+ theme, if any. */
-    parse_rc_file();
+    if (window == NULL) {
+        /* Open a new GTK top-level window */
+        window = Xdialog.window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
 
-    if (Xdialog.wmclass[0] != 0)
-        gtk_window_set_role (GTK_WINDOW(window), Xdialog.wmclass);
+        /* Apply the custom GTK+ theme, if any. */
+        parse_rc_file();
 
-    /* Set default events handlers */
-    g_signal_connect (G_OBJECT(window), "destroy",
-                      G_CALLBACK(destroy_event), NULL);
-    g_signal_connect (G_OBJECT(window), "delete_event",
-                      G_CALLBACK(delete_event), NULL);
+        if (Xdialog.wmclass[0] != 0)
+            gtk_window_set_role (GTK_WINDOW(window), Xdialog.wmclass);
+
+        /* Set default events handlers */
+        g_signal_connect (G_OBJECT(window), "destroy",
+                          G_CALLBACK(destroy_event), NULL);
+        g_signal_connect (G_OBJECT(window), "delete_event",
+                          G_CALLBACK(delete_event), NULL);
+
+        /* Set the internal border so that the child widgets do not
+         * expand to the whole window (prettier) */
+        gtk_container_set_border_width (GTK_CONTAINER (window), 7);
+#if GTK_CHECK_VERSION(2,0,0)
+        g_object_set_data(G_OBJECT(window), "reusable", GINT_TO_POINTER(TRUE));
+#endif
+    } else {
+        /* Forget about the previous dialog size */
+        gtk_window_set_default_size(GTK_WINDOW(window), -1, -1);
+    }
 
     /* Set the window title */
     gtk_window_set_title(GTK_WINDOW(window), Xdialog.title);
 
-    /* Set the internal border so that the child widgets do not
-     * expand to the whole window (prettier) */
-    gtk_container_set_border_width (GTK_CONTAINER (window), 7);
-
     /* main vbox */
     vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
     gtk_container_add(GTK_CONTAINER(window), vbox);
@@ -204,6 +401,15 @@ static void open_window(void)
 
     /* Set the window size and placement policy */
     set_window_size_and_placement();
+#if GTK_CHECK_VERSION(2,0,0)
+    if (gtk_widget_get_visible(window)) {
+        /* A reused window is shrunk (or grown) to the new dialog size */
+        gint width, height;
+        gtk_window_get_default_size(GTK_WINDOW(window), &width, &height);
+        gtk_window_resize(GTK_WINDOW(window), width > 0 ? width : 1,
+                          height > 0 ? height : 1);
+    }
+#endif
 
     if (Xdialog.beep & BEEP_BEFORE && Xdialog.exit_code != 2) {
         gdk_beep();
@@ -230,15 +436,15 @@ static void set_backtitle(gboolean sep_flag)
     GtkWidget *label;
     GtkWidget *hbox;
     GtkWidget *separator;
-    gchar     backtitle[MAX_BACKTITLE_LENGTH];
+    gchar     *backtitle;
 
     if (strlen(Xdialog.backtitle) == 0) {
         return;
     }
     if (dialog_compat)
-        backslash_n_to_linefeed(Xdialog.backtitle, backtitle, MAX_BACKTITLE_LENGTH);
+        backtitle = backslash_n_to_linefeed(Xdialog.backtitle);
     else
-        trim_string(Xdialog.backtitle, backtitle, MAX_BACKTITLE_LENGTH);
+        backtitle = trim_string(Xdialog.backtitle);
 
     if (Xdialog.wrap || dialog_compat) {
         wrap_text(backtitle, 2*ymult/3);
@@ -247,6 +453,7 @@ static void set_backtitle(gboolean sep_flag)
     gtk_box_pack_start (Xdialog.vbox, hbox, FALSE, FALSE, ymult/3);
     gtk_box_reorder_child(Xdialog.vbox, hbox, 0);
     label = gtk_label_new(backtitle);
+    g_free(backtitle);
     gtk_container_add(GTK_CONTAINER(hbox), label);
     if (sep_flag) {
         separator = set_separator(TRUE);
@@ -263,7 +470,7 @@ static GtkWidget *set_label(gchar *label_text, gboolean expand)
     GdkPixbuf *pixbuf;
     GtkWidget *icon;
 #endif
-    gchar     text[MAX_LABEL_LENGTH];
+    gchar     *text;
     int icon_width = 0;
 
     hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
@@ -282,12 +489,13 @@ static GtkWidget *set_label(gchar *label_text, gboolean expand)
         }
     }
 #endif
-    trim_string(label_text, text, MAX_LABEL_LENGTH);
+    text = trim_string(label_text);
 
     if (Xdialog.wrap || dialog_compat) {
         wrap_text(text, icon_width + 2*ymult/3);
     }
     label = gtk_label_new(text);
+    g_free(text);
 
     if (Xdialog.justify == GTK_JUSTIFY_FILL) {
         gtk_label_set_line_wrap(GTK_LABEL(label), TRUE);
@@ -296,6 +504,10 @@ static GtkWidget *set_label(gchar *label_text, gboolean expand)
 
     gtk_box_pack_start (GTK_BOX(hbox), label, TRUE, TRUE, ymult/3);
 
+    /* The main label of the box, for the control channel (see control.c) */
+    if (g_object_get_data(G_OBJECT(Xdialog.vbox), "label") == NULL)
+        g_object_set_data(G_OBJECT(Xdialog.vbox), "label", label);
+
     return label;
 }
 
@@ -303,13 +515,14 @@ static GtkWidget *set_label(gchar *label_text, gboolean expand)
 static GtkWidget *set_secondary_label(gchar *label_text, gboolean expand)
 {
     GtkWidget *label;
-    gchar     text[MAX_LABEL_LENGTH];
+    gchar     *text;
 
-    trim_string(label_text, text, MAX_LABEL_LENGTH);
+    text = trim_string(label_text);
     if (Xdialog.wrap || dialog_compat)
         wrap_text(text, 2*ymult/3);
 
     label = gtk_label_new(text);
+    g_free(text);
 
     if (Xdialog.justify == GTK_JUSTIFY_FILL) {
         gtk_label_set_line_wrap(GTK_LABEL(label), TRUE);
@@ -365,6 +578,10 @@ static GtkWidget *set_button(gchar *default_text,
             stock_id = "gtk-go-forward";
         else if (!strcmp(text, PREVIOUS) || !strcmp(text, REMOVE))
             stock_id = "gtk-go-back";
+        else if (!strcmp(text, ADD_ALL))
+            stock_id = "gtk-goto-last";
+        else if (!strcmp(text, REMOVE_ALL))
+            stock_id = "gtk-goto-first";
     }
 #endif
 
@@ -405,6 +622,14 @@ static GtkWidget *set_button(gchar *default_text,
     }
     gtk_container_add(GTK_CONTAINER(buttonbox), button);
 
+    /* Named after the event for the control channel (see control.c) */
+    if (event >= 0) {
+        static const gchar *names[] = {
+            "ok", "cancel", "help", "previous", "print", "extra"
+        };
+        g_object_set_data(G_OBJECT(Xdialog.vbox), names[event], button);
+    }
+
     switch (event) {
         case 0: // ok
             g_signal_connect_after (G_OBJECT(button), "clicked",
@@ -447,12 +672,12 @@ static void set_check_button(GtkWidget *box)
 {
     GtkWidget *button;
     GtkWidget *hbox;
-    gchar     check_label[MAX_LABEL_LENGTH];
+    gchar     *check_label;
 
     if (!Xdialog.check) {
         return;
     }
-    trim_string(Xdialog.check_label, check_label, MAX_LABEL_LENGTH);
+    check_label = trim_string(Xdialog.check_label);
 
     if (box == NULL) {
         set_separator(FALSE);
@@ -463,6 +688,7 @@ static void set_check_button(GtkWidget *box)
         hbox = box;
     }
     button = gtk_check_button_new_with_mnemonic (check_label);
+    g_free(check_label);
     gtk_container_add(GTK_CONTAINER(hbox), button);
 
     if (Xdialog.checked) {
@@ -570,43 +796,60 @@ static GtkWidget *set_scrolled_window (GtkBox *box, gint border_width, gint xsiz
 }
 
 
+/* Buildlist lists: each shows the items which state is "state" (1 for the
+ * chosen ones).  With GTK+ 2 and 3, both lists are filters over the same store
+ * of all the items (the one of "shared", NULL for the first list), so that they
+ * stay in the items order and moving items only means changing their state
+ * (see buildlist_add_or_remove()).
+ */
 static GtkWidget *set_scrolled_list (GtkWidget *box, gint xsize, gint list_size,
-                                     gint spacing, GList *glitems)
+                                     gint spacing, gint state, GtkWidget *shared)
 {
     GtkWidget *list_w;
-    GList *igl;
-    listname *listitem;
     GtkWidget *scrolled_window;
+    gint i;
     scrolled_window = set_scrolled_window (GTK_BOX(box), 0, xsize, list_size, spacing);
 #if GTK_CHECK_VERSION(2,0,0)
-    // liststore
     GtkListStore *store;
-    GtkTreeIter iter;
-    store = gtk_list_store_new (2,
-                                G_TYPE_STRING,   // name
-                                G_TYPE_POINTER); // listname*
-
-    for (igl = glitems; igl != NULL; igl = igl->next)
-    {
-        listitem = (listname *) igl->data;
-        gtk_list_store_append (store, &iter);
-        gtk_list_store_set (store, &iter,
-                            0, listitem->name,
-                            1, listitem,
-                            -1);
-    }
+    GtkTreeModel *filter;
+
+    if (shared == NULL) {
+        store = gtk_list_store_new (BUILDLIST_NUM_COLS,
+                                    G_TYPE_STRING,   // name
+                                    G_TYPE_POINTER); // listname*
+        for (i = 0; i < list_size; i++) {
+            gtk_list_store_insert_with_values (store, NULL, i,
+                                               BUILDLIST_COL_NAME, item_name(&Xdialog.array[i]),
+                                               BUILDLIST_COL_ITEM, &Xdialog.array[i],
+                                               -1);
+        }
+    } else {
+        filter = gtk_tree_view_get_model (GTK_TREE_VIEW(shared));
+        store = GTK_LIST_STORE(gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER(filter)));
+        g_object_ref (G_OBJECT(store));
+    }
+    filter = gtk_tree_model_filter_new (GTK_TREE_MODEL(store), NULL);
+    gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER(filter),
+                                            buildlist_row_visible,
+                                            GINT_TO_POINTER(state), NULL);
+    g_object_unref (G_OBJECT(store));
 
     // GtkTreeView
     GtkCellRenderer *renderer;
     GtkTreeViewColumn *column;
-    list_w = gtk_tree_view_new_with_model (GTK_TREE_MODEL(store));
-    g_object_unref (G_OBJECT(store));
+    list_w = gtk_tree_view_new_with_model (filter);
+    g_object_unref (G_OBJECT(filter));
     gtk_tree_view_set_headers_visible (GTK_TREE_VIEW(list_w), FALSE);
+    gtk_tree_selection_set_mode (gtk_tree_view_get_selection (GTK_TREE_VIEW(list_w)),
+                                 GTK_SELECTION_MULTIPLE);
 
     renderer = gtk_cell_renderer_text_new();
     column = gtk_tree_view_column_new_with_attributes ("", renderer,
-                                                       "text", 0, NULL);
+                                                       "text", BUILDLIST_COL_NAME, NULL);
+    gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_column_set_fixed_width (column, xsize*xmult);
     gtk_tree_view_append_column (GTK_TREE_VIEW(list_w), column);
+    gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW(list_w), TRUE);
 
     // don't use gtk_scrolled_window_add_with_viewport() with a GtkTreeView
     // use gtk_container_add() instead
@@ -615,15 +858,19 @@ static GtkWidget *set_scrolled_list (GtkWidget *box, gint xsize, gint list_size,
 #else // -- GTK1 --
     GtkWidget *item; // GtkListItem
     GList *gtklistitems = NULL;
-    for (igl = glitems; igl != NULL; igl = igl->next)
+    listname *listitem;
+    for (i = list_size - 1; i >= 0; i--)
     {
-        listitem = (listname *) igl->data;
-        item = gtk_list_item_new_with_label (listitem->name);
+        listitem = &Xdialog.array[i];
+        if (listitem->state != state) {
+            continue;
+        }
+        item = gtk_list_item_new_with_label (item_name(listitem));
         g_object_set_data (G_OBJECT(item), "listitem", (gpointer) listitem);
         gtk_widget_show(item);
-        gtklistitems = g_list_append (gtklistitems, item);
-        if (Xdialog.tips == 1 && strlen(listitem->tips) > 0) {
-            gtk_widget_set_tooltip_text (item, listitem->tips);
+        gtklistitems = g_list_prepend (gtklistitems, item);
+        if (Xdialog.tips == 1 && listitem->tips_len > 0) {
+            gtk_widget_set_tooltip_text (item, item_tips(listitem));
         }
     }
 
@@ -687,12 +934,17 @@ static GtkWidget *set_spin_button (GtkWidget *hbox, gint min, gint max, gint def
 }
 
 
+static gboolean item_unavailable(char *status, char *tag)
+{
+    return !strcasecmp(status, "unavailable") || *tag == '\0';
+}
+
 static int item_status(GtkWidget *item, char *status, char *tag)
 {
     if (!strcasecmp(status, "on") && strlen(tag) != 0) {
         return 1;
     }
-    if (!strcasecmp(status, "unavailable") || strlen(tag) == 0) {
+    if (item_unavailable(status, tag)) {
         if (item) { // this is only for checklists / radiolists
             gtk_widget_set_sensitive(item, FALSE);
             return -1;
@@ -710,6 +962,27 @@ static void set_timeout(void)
 }
 
 
+/* --interval and --report-changes: "printer" outputs the widget result, either
+ * periodically or each time it changes (see watch_changes()).
+ */
+static void set_interval(GSourceFunc printer)
+{
+    if (Xdialog.report_changes) {
+        report_changes_init(printer);
+    } else if (Xdialog.interval > 0) {
+        Xdialog.timer = watched_timeout_add(Xdialog.interval, interval_report, (gpointer) printer);
+    }
+}
+
+/* Makes a result change reported (with --report-changes) on "signal" */
+static void watch_changes(gpointer object, const gchar *signal)
+{
+    if (Xdialog.report_changes && object != NULL) {
+        g_signal_connect (G_OBJECT(object), signal, G_CALLBACK(report_changed), NULL);
+    }
+}
+
+
 /* ==============================================================================
  * The Xdialog widgets...
  * ============================================================================== */
@@ -772,13 +1045,13 @@ void create_infobox(gchar *optarg, gint timeout)
                     timeout > 0 ? 0 : 1, TRUE);
     }
 
-    Xdialog.label_text[0] = 0;
+    reset_label_text(NULL);
     Xdialog.new_label = Xdialog.check = FALSE;
 
     if (timeout > 0)
         Xdialog.timer = g_timeout_add(timeout, infobox_timeout_exit, NULL);
     else
-        Xdialog.timer = g_timeout_add(10, infobox_timeout, NULL);
+        Xdialog.timer = watched_timeout_add(10, infobox_timeout, NULL);
 }
 
 
@@ -828,13 +1101,15 @@ void create_gauge(gchar *optarg, gint percent)
     gtk_progress_set_show_text (GTK_PROGRESS(pbar), TRUE);
 #endif
     Xdialog.widget1 = pbar;
+    g_object_set_data(G_OBJECT(Xdialog.vbox), "progress_bar", pbar);
     gtk_box_pack_start (GTK_BOX (hbox), Xdialog.widget1, TRUE, TRUE, 10);
 
-    Xdialog.label_text[0] = 0;
+    reset_label_text(NULL);
     Xdialog.new_label = Xdialog.check = FALSE;
 
     /* Add a timer callback to update the value of the progress bar */
-    Xdialog.timer = g_timeout_add(10, gauge_timeout, NULL);
+    Xdialog.timer = watched_timeout_add(10, gauge_timeout, NULL);
+    stats_init(0);
 }
 
 
@@ -854,6 +1129,7 @@ void create_progress(gchar *optarg, gint leading, gint maxdots)
     int i;
     unsigned char temp[2];
     size_t rresult;
+    gchar *text;
 
 #if GTK_CHECK_VERSION(2,0,0)
     if (maxdots <= 0) {
@@ -875,8 +1151,10 @@ void create_progress(gchar *optarg, gint leading, gint maxdots)
 
     set_backtitle(TRUE);
 
-    trim_string(optarg, Xdialog.label_text, MAX_LABEL_LENGTH);
-    label = set_label(Xdialog.label_text, TRUE);
+    text = trim_string(optarg);
+    reset_label_text(text);
+    g_free(text);
+    label = set_label(Xdialog.label_text->str, TRUE);
     hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
     gtk_box_pack_start (Xdialog.vbox, hbox, FALSE, TRUE, 0);
 
@@ -899,6 +1177,7 @@ void create_progress(gchar *optarg, gint leading, gint maxdots)
     gtk_progress_set_show_text (GTK_PROGRESS(pbar), TRUE);
 #endif
     Xdialog.widget1 = pbar;
+    g_object_set_data(G_OBJECT(Xdialog.vbox), "progress_bar", pbar);
     gtk_box_pack_start (GTK_BOX (hbox), Xdialog.widget1, TRUE, TRUE, 10);
 
     /* Skip the characters to be ignored on the input stream */
@@ -916,16 +1195,16 @@ void create_progress(gchar *optarg, gint leading, gint maxdots)
                 break;
             }
             if (temp[0] >= ' ' || temp[0] == '\n') {
-                strncat(Xdialog.label_text, (char*)temp, sizeof(Xdialog.label_text));
+                g_string_append_c(Xdialog.label_text, (gchar) temp[0]);
             }
         }
-        gtk_label_set_text(GTK_LABEL(label), Xdialog.label_text);
+        gtk_label_set_text(GTK_LABEL(label), Xdialog.label_text->str);
     }
 
     Xdialog.check = FALSE;
 
     /* Add a timer callback to update the value of the progress bar */
-    Xdialog.timer = g_timeout_add(10, progress_timeout, NULL);
+    Xdialog.timer = watched_timeout_add(10, progress_timeout, NULL);
 }
 
 
@@ -952,7 +1231,7 @@ void create_tailbox(gchar *optarg)
 
     if (Xdialog.file == NULL) {
         fprintf(stderr, "Xdialog: can't open %s\n", optarg);
-        exit(255);
+        xdialog_exit(255);
     }
 
     if (Xdialog.file != stdin) {
@@ -966,7 +1245,7 @@ void create_tailbox(gchar *optarg)
 
     if (Xdialog.file == NULL) {
         fprintf(stderr, "Xdialog: can't open %s\n", optarg);
-        exit(255);
+        xdialog_exit(255);
     }
 
     if (dialog_compat) {
@@ -975,7 +1254,8 @@ void create_tailbox(gchar *optarg)
     if (Xdialog.buttons) {
         set_all_buttons(TRUE, Xdialog.ok_button);
     }
-    Xdialog.timer = g_timeout_add(10, (GSourceFunc) tailbox_timeout, NULL);
+    Xdialog.timer = watched_timeout_add(10, tailbox_timeout, NULL);
+    stats_init(fileno(Xdialog.file));
 
     set_timeout();
 }
@@ -1091,7 +1371,7 @@ void create_logbox(gchar *optarg)
     }
     if (Xdialog.file == NULL) {
         fprintf(stderr, "Xdialog: can't open %s\n", optarg);
-        exit(255);
+        xdialog_exit(255);
     }
 
     if (Xdialog.file != stdin) {
@@ -1105,7 +1385,9 @@ void create_logbox(gchar *optarg)
     if (Xdialog.buttons)
         set_all_buttons(FALSE, Xdialog.ok_button);
 
-    Xdialog.timer = g_timeout_add(10, (GSourceFunc) logbox_timeout, NULL);
+    logbox_start(Xdialog.file);
+    Xdialog.timer = watched_timeout_add(10, logbox_timeout, NULL);
+    stats_init(fileno(Xdialog.file));
 
     set_timeout();
 }
@@ -1153,6 +1435,7 @@ void create_textbox(gchar *optarg, gboolean editable)
     if (infile) {
         char buffer[1024];
         int nchars;
+        watchdog_begin("create_textbox");
         do {
             nchars = fread(buffer, 1, 1024, infile);
 #if GTK_CHECK_VERSION(2,0,0)
@@ -1182,9 +1465,11 @@ void create_textbox(gchar *optarg, gboolean editable)
                     lcnt++;
                 }
         } while (nchars == 1024);
+        watchdog_end();
 
         if (infile != stdin) {
             fclose(infile);
+            Xdialog.print_file = optarg;
         }
     }
     llen += 4;
@@ -1204,6 +1489,8 @@ void create_textbox(gchar *optarg, gboolean editable)
     GtkTextIter firstLineIter;
     gtk_text_buffer_get_start_iter(text_buffer, &firstLineIter);
     gtk_text_buffer_place_cursor(text_buffer, &firstLineIter);
+    // the buffer matches the file until it is edited (see print_text)
+    gtk_text_buffer_set_modified(text_buffer, FALSE);
 #else // -- GTK1 --
     gtk_text_thaw (GTK_TEXT(text));
     gtk_text_set_editable (GTK_TEXT(text), editable);
@@ -1293,8 +1580,10 @@ void create_inputbox(gchar *optarg, gchar *options[], gint entries)
         g_signal_connect (G_OBJECT(button_ok), "clicked", G_CALLBACK(inputbox_ok), NULL);
     }
 
-    if (Xdialog.interval > 0)
-        Xdialog.timer = g_timeout_add(Xdialog.interval, inputbox_timeout, NULL);
+    watch_changes(Xdialog.widget1, "changed");
+    watch_changes(Xdialog.widget2, "changed");
+    watch_changes(Xdialog.widget3, "changed");
+    set_interval(inputbox_timeout);
 
     set_timeout();
 }
@@ -1304,16 +1593,134 @@ void create_inputbox(gchar *optarg, gchar *options[], gint entries)
 //                             create_combobox
 // ------------------------------------------------------------------------------------------
 
-void create_combobox(gchar *optarg, gchar *options[], gint list_size)
+#if GTK_CHECK_VERSION(2,4,0)
+#if GTK_CHECK_VERSION(2,16,0)
+/* Full list of a large combobox, in the order of the items, popped up by the
+ * entry icon: a fixed height mode tree view copes with any number of rows.
+ */
+static void combo_popup_cell_data (GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                                   GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
 {
-    GtkWidget *combo;
-    GtkWidget *button_ok = NULL;
+    gint i;
+
+    gtk_tree_model_get (model, iter, 0, &i, -1);
+    g_object_set (renderer, "text", item_name(&Xdialog.array[i]), NULL);
+}
+
+static GtkWidget *set_combo_popup (GtkWidget *entry, gint list_size)
+{
+    GtkWidget *popup, *scrolled_window, *treeview;
+    GtkTreeViewColumn *column;
+    GtkCellRenderer *renderer;
+    GtkListStore *store;
+    gint i;
+
+    store = gtk_list_store_new (1, G_TYPE_INT);
+    for (i = 0; i < list_size; i++) {
+        gtk_list_store_insert_with_values (store, NULL, -1, 0, i, -1);
+    }
+    treeview = gtk_tree_view_new_with_model (GTK_TREE_MODEL(store));
+    g_object_unref (G_OBJECT(store));
+    gtk_tree_view_set_headers_visible (GTK_TREE_VIEW(treeview), FALSE);
+    gtk_tree_view_set_enable_search (GTK_TREE_VIEW(treeview), FALSE);
+    renderer = gtk_cell_renderer_text_new ();
+    column = gtk_tree_view_column_new ();
+    gtk_tree_view_column_pack_start (column, renderer, TRUE);
+    gtk_tree_view_column_set_cell_data_func (column, renderer,
+                                             combo_popup_cell_data, NULL, NULL);
+    gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_append_column (GTK_TREE_VIEW(treeview), column);
+    gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW(treeview), TRUE);
+
+    scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+    gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW(scrolled_window),
+                                    GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW(scrolled_window),
+                                         GTK_SHADOW_ETCHED_IN);
+    gtk_widget_set_size_request (scrolled_window, -1, 12 * ymult);
+    gtk_container_add (GTK_CONTAINER(scrolled_window), treeview);
+
+    /* an undecorated window (rather than a popup one) gets the focus from
+     * the window manager, and is hidden when it loses it */
+    popup = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_decorated (GTK_WINDOW(popup), FALSE);
+    gtk_window_set_type_hint (GTK_WINDOW(popup), GDK_WINDOW_TYPE_HINT_COMBO);
+    gtk_window_set_skip_taskbar_hint (GTK_WINDOW(popup), TRUE);
+    gtk_window_set_skip_pager_hint (GTK_WINDOW(popup), TRUE);
+    gtk_window_set_transient_for (GTK_WINDOW(popup), GTK_WINDOW(Xdialog.window));
+    gtk_container_add (GTK_CONTAINER(popup), scrolled_window);
+    gtk_widget_show_all (scrolled_window);
+    g_object_set_data (G_OBJECT(popup), "treeview", treeview);
+
+    g_signal_connect (G_OBJECT(treeview), "row-activated",
+                      G_CALLBACK(combo_popup_activated), entry);
+    g_signal_connect_after (G_OBJECT(treeview), "button-release-event",
+                            G_CALLBACK(combo_popup_click), entry);
+    g_signal_connect (G_OBJECT(popup), "key-press-event",
+                      G_CALLBACK(combo_popup_keypress), NULL);
+    g_signal_connect (G_OBJECT(popup), "focus-out-event",
+                      G_CALLBACK(combo_popup_focus_out), NULL);
+    /* the popup goes with the entry (and the window may be reused) */
+    g_object_set_data_full (G_OBJECT(entry), "combo_popup", popup,
+                            (GDestroyNotify) gtk_widget_destroy);
+    return popup;
+}
+#endif
+
+/* Large combobox: a combo popup menu would hold one widget per item, so the
+ * combo is replaced with an entry which completion is fed with the items
+ * starting with the entry text (see combo_entry_changed()), the completion
+ * popup being a list view which only draws the visible rows.  The items are
+ * typed into, or picked from this popup (also shown by the entry icon).
+ * Returns the completion model.
+ */
+static GtkListStore *set_large_combo (gchar *options[], gint list_size)
+{
+    GtkEntryCompletion *completion;
+    GtkListStore *store;
     int i;
 
-    open_window();
+    Xdialog_array(list_size);
+    for (i = 0; i < list_size; i++) {
+        set_list_item(i, "", options[i], NULL);
+    }
+    combo_index_init(list_size);
 
-    set_backtitle(TRUE);
-    set_label(optarg, TRUE);
+    Xdialog.widget1 = gtk_entry_new();
+    gtk_box_pack_start (Xdialog.vbox, Xdialog.widget1, TRUE, TRUE, 0);
+    gtk_entry_set_text (GTK_ENTRY(Xdialog.widget1), Xdialog.default_item);
+#if GTK_CHECK_VERSION(2,16,0)
+#if GTK_CHECK_VERSION(3,0,0)
+    gtk_entry_set_icon_from_icon_name (GTK_ENTRY(Xdialog.widget1), GTK_ENTRY_ICON_SECONDARY,
+                                       "go-down");
+#else
+    gtk_entry_set_icon_from_stock (GTK_ENTRY(Xdialog.widget1), GTK_ENTRY_ICON_SECONDARY,
+                                   "gtk-go-down");
+#endif
+    g_signal_connect (G_OBJECT(Xdialog.widget1), "icon-press", G_CALLBACK(combo_icon_press),
+                      set_combo_popup (Xdialog.widget1, list_size));
+#endif
+
+    store = gtk_list_store_new (1, G_TYPE_STRING);
+    g_signal_connect (G_OBJECT(Xdialog.widget1), "changed",
+                      G_CALLBACK(combo_entry_changed), store);
+
+    completion = gtk_entry_completion_new ();
+    gtk_entry_completion_set_model (completion, GTK_TREE_MODEL(store));
+    g_object_unref (G_OBJECT(store));
+    gtk_entry_completion_set_text_column (completion, 0);
+    gtk_entry_completion_set_match_func (completion, combo_completion_match, NULL, NULL);
+    gtk_entry_completion_set_minimum_key_length (completion, 0);
+    gtk_entry_set_completion (GTK_ENTRY(Xdialog.widget1), completion);
+    g_object_unref (G_OBJECT(completion));
+    return store;
+}
+#endif
+
+static void set_combo_box (gchar *options[], gint list_size)
+{
+    GtkWidget *combo;
+    int i;
 
     combo = gtk_combo_box_text_new_with_entry ();
 #if GTK_CHECK_VERSION(2,4,0)
@@ -1321,9 +1728,7 @@ void create_combobox(gchar *optarg, gchar *options[], gint list_size)
 #else
     Xdialog.widget1 = GTK_COMBO(combo)->entry;
 #endif
-    Xdialog.widget2 = Xdialog.widget3 = NULL;
     gtk_box_pack_start (Xdialog.vbox, combo, TRUE, TRUE, 0);
-    gtk_widget_grab_focus(Xdialog.widget1);
 
     /* Set the popdown strings */
     for (i = 0; i < list_size; i++) {
@@ -1336,14 +1741,49 @@ void create_combobox(gchar *optarg, gchar *options[], gint list_size)
     }
 
     gtk_editable_set_editable (GTK_EDITABLE(Xdialog.widget1), Xdialog.editable);
+}
+
+void create_combobox(gchar *optarg, gchar *options[], gint list_size)
+{
+    GtkWidget *button_ok = NULL;
+#if GTK_CHECK_VERSION(2,4,0)
+    GtkListStore *store = NULL;
+#endif
+
+    open_window();
+
+    set_backtitle(TRUE);
+    set_label(optarg, TRUE);
+
+#if GTK_CHECK_VERSION(2,4,0)
+    if (list_size > COMBOBOX_LARGE_LIST)
+        store = set_large_combo (options, list_size);
+    else
+#endif
+        set_combo_box (options, list_size);
+
+    Xdialog.widget2 = Xdialog.widget3 = NULL;
+    gtk_widget_grab_focus(Xdialog.widget1);
 
     if (Xdialog.buttons) {
         button_ok = set_all_buttons(FALSE, TRUE);
         g_signal_connect (G_OBJECT(button_ok), "clicked", G_CALLBACK(inputbox_ok), NULL);
     }
 
-    if (Xdialog.interval > 0)
-        Xdialog.timer = g_timeout_add(Xdialog.interval, inputbox_timeout, NULL);
+#if GTK_CHECK_VERSION(2,4,0)
+    /* Without --editable, the OK button is only sensitive for a listed item */
+    if (store != NULL) {
+        if (!Xdialog.editable) {
+            g_object_set_data (G_OBJECT(Xdialog.widget1), "ok_button", button_ok);
+        }
+        combo_entry_changed (GTK_EDITABLE(Xdialog.widget1), store);
+    }
+#endif
+
+    watch_changes(Xdialog.widget1, "changed");
+    watch_changes(Xdialog.widget2, "changed");
+    watch_changes(Xdialog.widget3, "changed");
+    set_interval(inputbox_timeout);
 
     set_timeout();
 }
@@ -1406,8 +1846,10 @@ void create_rangebox(gchar *optarg, gchar *options[], gint ranges)
     button_ok = set_all_buttons(FALSE, TRUE);
     g_signal_connect (G_OBJECT(button_ok), "clicked", G_CALLBACK(rangebox_exit), NULL);
 
-    if (Xdialog.interval > 0)
-            Xdialog.timer = g_timeout_add(Xdialog.interval, rangebox_timeout, NULL);
+    watch_changes(Xdialog.widget1, "value_changed");
+    watch_changes(Xdialog.widget2, "value_changed");
+    watch_changes(Xdialog.widget3, "value_changed");
+    set_interval(rangebox_timeout);
 
     set_timeout();
 }
@@ -1455,9 +1897,10 @@ void create_spinbox(gchar *optarg, gchar *options[], gint spins)
 
     g_signal_connect (G_OBJECT(button_ok), "clicked", G_CALLBACK(spinbox_exit), NULL);
 
-    if (Xdialog.interval > 0) {
-        Xdialog.timer = g_timeout_add(Xdialog.interval, spinbox_timeout, NULL);
-    }
+    watch_changes(Xdialog.widget1, "value_changed");
+    watch_changes(Xdialog.widget2, "value_changed");
+    watch_changes(Xdialog.widget3, "value_changed");
+    set_interval(spinbox_timeout);
     set_timeout();
 }
 
@@ -1466,14 +1909,127 @@ void create_spinbox(gchar *optarg, gchar *options[], gint spins)
 //                            create_itemlist
 // ------------------------------------------------------------------------------------------
 
+#if GTK_CHECK_VERSION(2,0,0)
+typedef struct {
+    gint column;
+    listname *item;
+    GtkTreePath *path;
+} find_row_data;
+
+static gboolean find_item_row (GtkTreeModel *model, GtkTreePath *path,
+                               GtkTreeIter *iter, gpointer data)
+{
+    find_row_data *find = data;
+    listname *item;
+
+    gtk_tree_model_get (model, iter, find->column, &item, -1);
+    if (item == find->item) {
+        find->path = gtk_tree_path_copy (path);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* Moves the cursor of a list or tree view to the --default-item row.  The
+ * item is found through the tags index, its row being the item index for
+ * "column" < 0, or else looked up through the listname pointers of "column".
+ */
+static void set_default_row (GtkTreeView *treeview, gint column)
+{
+    find_row_data find;
+    gint i = find_list_item(Xdialog.default_item);
+
+    if (i < 0) {
+        return;
+    }
+    if (column < 0) {
+        find.path = gtk_tree_path_new_from_indices (i, -1);
+    } else {
+        find.column = column;
+        find.item = &Xdialog.array[i];
+        find.path = NULL;
+        gtk_tree_model_foreach (gtk_tree_view_get_model (treeview), find_item_row, &find);
+        if (find.path == NULL) {
+            return;
+        }
+    }
+    gtk_tree_view_expand_to_path (treeview, find.path);
+    gtk_tree_view_set_cursor (treeview, find.path, NULL, FALSE);
+    gtk_tree_view_scroll_to_cell (treeview, find.path, NULL, TRUE, 0.5, 0.5);
+    gtk_tree_path_free (find.path);
+}
+
+/* --filter: wraps the model of a menu or list view into a GtkTreeModelFilter
+ * driven by an entry, which is packed into "box" just above "below".  The
+ * "column" of the model holds the item index or listname pointer.  Returns
+ * the entry.
+ */
+static GtkWidget *set_list_filter (GtkBox *box, GtkWidget *below, GtkTreeView *treeview,
+                                    gint column, gint list_size)
+{
+    GtkTreeModel *filter;
+    GtkWidget *entry;
+    gint position;
+
+    list_filter_init (list_size, column);
+    /* the buildlist views are filters already, see buildlist_row_visible() */
+    if (!GTK_IS_TREE_MODEL_FILTER(gtk_tree_view_get_model (treeview))) {
+        filter = gtk_tree_model_filter_new (gtk_tree_view_get_model (treeview), NULL);
+        gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER(filter),
+                                                list_filter_visible,
+                                                GINT_TO_POINTER(column), NULL);
+        gtk_tree_view_set_model (treeview, filter);
+        g_object_unref (G_OBJECT(filter));
+    }
+
+    entry = gtk_entry_new ();
+    gtk_box_pack_start (box, entry, FALSE, FALSE, ymult/3);
+    gtk_container_child_get (GTK_CONTAINER(box), below, "position", &position, NULL);
+    gtk_box_reorder_child (box, entry, position);
+    gtk_entry_set_activates_default (GTK_ENTRY(entry), TRUE);
+    g_signal_connect (G_OBJECT(entry), "changed",
+                      G_CALLBACK(list_filter_changed), treeview);
+    gtk_widget_grab_focus (entry);
+    return entry;
+}
+
+/* The checklist/radiolist rows only hold the item index and sensitivity: the
+ * label and the check state are taken from Xdialog.array when a row is drawn.
+ */
+static void itemlist_cell_data (GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                                GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+{
+    listname *item;
+    gchar *text;
+    gint i;
+    gboolean sensitive;
+
+    gtk_tree_model_get (model, iter,
+                        ITEMLIST_COL_INDEX, &i,
+                        ITEMLIST_COL_SENSITIVE, &sensitive,
+                        -1);
+    item = &Xdialog.array[i];
+
+    if (GTK_IS_CELL_RENDERER_TOGGLE(renderer)) {
+        g_object_set (renderer,
+                      "active", item->state == 1,
+                      "activatable", sensitive,
+                      "sensitive", sensitive,
+                      NULL);
+    } else if (Xdialog.tags && item->tag_len != 0) {
+        text = g_strconcat (item_tag(item), ": ", item_name(item), NULL);
+        g_object_set (renderer, "text", text, "sensitive", sensitive, NULL);
+        g_free (text);
+    } else {
+        g_object_set (renderer, "text", item_name(item), "sensitive", sensitive, NULL);
+    }
+}
+#endif
+
 void create_itemlist(gchar *optarg, gint type, gchar *options[], gint list_size)
 { // radiolist / checklist
-    GtkWidget *vbox;
     GtkWidget *scrolled_window;
     GtkWidget *button_ok;
-    GtkWidget *item;
-    GtkRadioButton *radio = NULL;
-    char temp[MAX_ITEM_LENGTH];
     int i;
     int params = 3 + Xdialog.tips;
     char *status;
@@ -1487,16 +2043,121 @@ void create_itemlist(gchar *optarg, gint type, gchar *options[], gint list_size)
 
     scrolled_window = set_scrolled_window(Xdialog.vbox, xmult/2, -1, list_size, ymult + 5);
 
+    button_ok = set_all_buttons(FALSE, TRUE);
+    g_signal_connect (G_OBJECT(button_ok), "clicked", G_CALLBACK(print_items), NULL);
+
+#if GTK_CHECK_VERSION(2,0,0)
+    GtkListStore *store;
+    GtkTreeView *treeview;
+    GtkTreeViewColumn *column;
+    GtkCellRenderer *renderer;
+    gboolean sensitive;
+    gint radio_row = 0;
+    listname *item;
+    gsize width = 0, len;
+
+    /* Fill the model before it is attached to the view: a single pass, with
+     * no per-row signal, widget or measurement.  A radiolist always has one
+     * active item: the last "on" one, or else the first one (as with a group
+     * of GtkRadioButtons).
+     */
+    store = gtk_list_store_new (ITEMLIST_NUM_COLS,
+                                G_TYPE_INT,       // index into Xdialog.array
+                                G_TYPE_BOOLEAN);  // sensitive
+    for (i = 0; i < list_size; i++)
+    {
+        set_list_item(i, options[params*i], options[params*i+1],
+                      Xdialog.tips == 1 ? options[params*i+3] : NULL);
+        status = options[params*i+2];
+        sensitive = !item_unavailable(status, options[params*i]);
+
+        if (item_status(NULL, status, options[params*i]) == 1) {
+            if (type == RADIOLIST) {
+                Xdialog.array[radio_row].state = 0;
+                radio_row = i;
+            }
+            Xdialog.array[i].state = 1;
+        }
+        /* in characters, only counted when the bytes could be wider */
+        item = &Xdialog.array[i];
+        if (item->name_len + (Xdialog.tags ? item->tag_len + 2 : 0) > width) {
+            len = g_utf8_strlen (item_name(item), -1);
+            if (Xdialog.tags)
+                len += g_utf8_strlen (item_tag(item), -1) + 2;
+            width = MAX(width, len);
+        }
+
+        gtk_list_store_insert_with_values (store, NULL, i,
+                                           ITEMLIST_COL_INDEX, i,
+                                           ITEMLIST_COL_SENSITIVE, sensitive,
+                                           -1);
+    }
+    if (type == RADIOLIST) {
+        Xdialog.array[radio_row].state = 1;
+    }
+
+    Xdialog.widget1 = gtk_tree_view_new_with_model (GTK_TREE_MODEL(store));
+    treeview = GTK_TREE_VIEW(Xdialog.widget1);
+    g_object_set_data (G_OBJECT(treeview), "radio_item", GINT_TO_POINTER(radio_row));
+    g_object_set_data (G_OBJECT(treeview), "list_type", GINT_TO_POINTER(type));
+    g_object_unref (G_OBJECT(store));
+    gtk_tree_view_set_headers_visible (treeview, FALSE);
+
+    /* A single fixed width column, so that only the visible rows are measured
+     * (width taken from the longest "tag: name" label) */
+    column = gtk_tree_view_column_new ();
+    gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_column_set_fixed_width (column, (width + 6) * xmult);
+
+    renderer = gtk_cell_renderer_toggle_new ();
+    gtk_cell_renderer_toggle_set_radio (GTK_CELL_RENDERER_TOGGLE(renderer),
+                                        type == RADIOLIST);
+    gtk_tree_view_column_pack_start (column, renderer, FALSE);
+    gtk_tree_view_column_set_cell_data_func (column, renderer,
+                                             itemlist_cell_data, NULL, NULL);
+    g_signal_connect (G_OBJECT(renderer), "toggled",
+                      G_CALLBACK(itemlist_toggled), GINT_TO_POINTER(type));
+
+    renderer = gtk_cell_renderer_text_new ();
+    gtk_tree_view_column_pack_start (column, renderer, TRUE);
+    gtk_tree_view_column_set_cell_data_func (column, renderer,
+                                             itemlist_cell_data, NULL, NULL);
+
+    gtk_tree_view_append_column (treeview, column);
+    gtk_tree_view_set_fixed_height_mode (treeview, TRUE);
+
+    gtk_tree_selection_set_mode (gtk_tree_view_get_selection (treeview),
+                                 GTK_SELECTION_BROWSE);
+    g_signal_connect (G_OBJECT(treeview), "row_activated",
+                      G_CALLBACK(itemlist_row_activated), GINT_TO_POINTER(type));
+    g_signal_connect (G_OBJECT(treeview), "button_press_event",
+                      G_CALLBACK(double_click_event), button_ok);
+    if (Xdialog.tips == 1) {
+        gtk_widget_set_has_tooltip (Xdialog.widget1, TRUE);
+        g_signal_connect (G_OBJECT(treeview), "query-tooltip",
+                          G_CALLBACK(itemlist_query_tooltip), NULL);
+    }
+
+    gtk_container_add (GTK_CONTAINER(scrolled_window), Xdialog.widget1);
+    if (Xdialog.filter) {
+        set_list_filter (Xdialog.vbox, scrolled_window, treeview, ITEMLIST_COL_INDEX, list_size);
+    }
+    set_default_row (treeview, -1);
+
+#else // -- GTK1 --
+
+    GtkWidget *vbox;
+    GtkWidget *item;
+    GtkRadioButton *radio = NULL;
+    char temp[MAX_ITEM_LENGTH];
+
     vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, xmult);
     gtk_container_set_border_width(GTK_CONTAINER(vbox), xmult);
     gtk_scrolled_window_add_with_viewport(GTK_SCROLLED_WINDOW(scrolled_window), vbox);
 
-    button_ok = set_all_buttons(FALSE, TRUE);
-    g_signal_connect (G_OBJECT(button_ok), "clicked", G_CALLBACK(print_items), NULL);
-
     for (i = 0;  i < list_size; i++)
     {
-        strncpy(Xdialog.array[i].tag, options[params*i], sizeof(Xdialog.array[i].tag) );
+        set_list_item(i, options[params*i], NULL, NULL);
         temp[0] = 0;
         if (Xdialog.tags && strlen(options[params*i]) != 0) {
             strncpy(temp, options[params*i], sizeof(temp));
@@ -1513,7 +2174,7 @@ void create_itemlist(gchar *optarg, gint type, gchar *options[], gint list_size)
         }
         gtk_box_pack_start (GTK_BOX(vbox), item, FALSE, FALSE, 0);
 
-        if (item_status(item, status, Xdialog.array[i].tag) == 1) {
+        if (item_status(item, status, options[params*i]) == 1) {
             gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(item), TRUE);
         }
         g_signal_connect (G_OBJECT(item), "toggled",
@@ -1526,10 +2187,10 @@ void create_itemlist(gchar *optarg, gint type, gchar *options[], gint list_size)
             gtk_widget_set_tooltip_text (item, (gchar *) options[params*i+3]);
         }
     }
+#endif
 
-    if (Xdialog.interval > 0) {
-        Xdialog.timer = g_timeout_add(Xdialog.interval, itemlist_timeout, NULL);
-    }
+    /* the toggles report their changes themselves */
+    set_interval(itemlist_timeout);
     set_timeout();
 }
 
@@ -1544,9 +2205,9 @@ void create_buildlist (gchar *optarg, gchar *options[], gint list_size)
     GtkWidget *vbuttonbox;
     GtkWidget *button_add;
     GtkWidget *button_remove;
+    GtkWidget *button_add_all;
+    GtkWidget *button_remove_all;
     GtkWidget *button_ok;
-    GList *glist1 = NULL;
-    GList *glist2 = NULL;
     gint i, n = 0;
     int params = 3 + Xdialog.tips;
     char *status;
@@ -1561,20 +2222,14 @@ void create_buildlist (gchar *optarg, gchar *options[], gint list_size)
     /* Put all parameters into an array and calculate the max item width */
     for (i = 0;  i < list_size; i++)
     {
-        strncpy (Xdialog.array[i].tag, options[params*i], sizeof(Xdialog.array[i].tag));
-        strncpy (Xdialog.array[i].name, options[params*i+1], sizeof(Xdialog.array[i].name));
+        set_list_item(i, options[params*i], options[params*i+1],
+                      Xdialog.tips == 1 ? options[params*i+3] : NULL);
         status = options[params*i+2];
-        if (Xdialog.tips == 1) {
-            strncpy(Xdialog.array[i].tips, options[params*i+3], sizeof(Xdialog.array[i].tips));
-        }
-        if ((gint) strlen(Xdialog.array[i].name) > n) {
-            n = strlen(Xdialog.array[i].name);
-        }
-        if (item_status(NULL, status, Xdialog.array[i].tag) == 1) {
-            glist2 = g_list_append (glist2, &Xdialog.array[i]);
-        } else {
-            glist1 = g_list_append (glist1, &Xdialog.array[i]);
+        if ((gint) Xdialog.array[i].name_len > n) {
+            n = Xdialog.array[i].name_len;
         }
+        /* the item state tells which list it is in */
+        Xdialog.array[i].state = item_status(NULL, status, options[params*i]) == 1;
     }
 
     /* Setup a hbox to hold the scrolled windows and the Add/Remove buttons */
@@ -1582,7 +2237,7 @@ void create_buildlist (gchar *optarg, gchar *options[], gint list_size)
     gtk_box_pack_start (Xdialog.vbox, hbox, TRUE, TRUE, ymult/3);
 
     /* Setup the first list into a scrolled window */
-    Xdialog.widget1 = set_scrolled_list(hbox, MAX(25, n), list_size, 4, glist1);
+    Xdialog.widget1 = set_scrolled_list(hbox, MAX(25, n), list_size, 4, 0, NULL);
 
     /* Setup the Add/Remove buttons */
     vbuttonbox = gtk_button_box_new (GTK_ORIENTATION_VERTICAL);
@@ -1593,15 +2248,25 @@ void create_buildlist (gchar *optarg, gchar *options[], gint list_size)
     g_signal_connect (G_OBJECT(button_add), "clicked",
                       G_CALLBACK(buildlist_add_or_remove), NULL);
 
+    button_add_all = set_button(ADD_ALL, vbuttonbox, -1, FALSE);
+    g_signal_connect (G_OBJECT(button_add_all), "clicked",
+                      G_CALLBACK(buildlist_add_or_remove), GINT_TO_POINTER(BUILDLIST_ALL));
+
+    button_remove_all = set_button(REMOVE_ALL, vbuttonbox, -1, FALSE);
+    g_signal_connect (G_OBJECT(button_remove_all), "clicked",
+                      G_CALLBACK(buildlist_add_or_remove),
+                      GINT_TO_POINTER(BUILDLIST_REMOVE | BUILDLIST_ALL));
+
     button_remove = Xdialog.widget4 = set_button(REMOVE, vbuttonbox, -1, FALSE);
     g_signal_connect (G_OBJECT(button_remove), "clicked",
-                      G_CALLBACK(buildlist_add_or_remove), GINT_TO_POINTER(1));
+                      G_CALLBACK(buildlist_add_or_remove), GINT_TO_POINTER(BUILDLIST_REMOVE));
 
-    /* Setup the second list into a scrolled window */
-    Xdialog.widget2 = set_scrolled_list(hbox, MAX(25, n), list_size, 4, glist2);
+    /* the "all" buttons follow the sensitivity of the Add/Remove ones */
+    g_object_set_data (G_OBJECT(button_add), "all_button", button_add_all);
+    g_object_set_data (G_OBJECT(button_remove), "all_button", button_remove_all);
 
-    g_list_free (glist1);
-    g_list_free (glist2);
+    /* Setup the second list into a scrolled window */
+    Xdialog.widget2 = set_scrolled_list(hbox, MAX(25, n), list_size, 4, 1, Xdialog.widget1);
 
     button_ok = set_all_buttons(FALSE, TRUE);
     g_signal_connect (G_OBJECT(button_ok), "clicked",
@@ -1609,6 +2274,20 @@ void create_buildlist (gchar *optarg, gchar *options[], gint list_size)
 
     buildlist_sensitive_buttons();
 
+#if GTK_CHECK_VERSION(2,0,0)
+    /* --filter applies to the list of the items to choose from */
+    if (Xdialog.filter) {
+        GtkWidget *entry = set_list_filter (Xdialog.vbox, hbox, GTK_TREE_VIEW(Xdialog.widget1),
+                                            BUILDLIST_COL_ITEM, list_size);
+        g_signal_connect_after (G_OBJECT(entry), "changed",
+                                G_CALLBACK(buildlist_sensitive_buttons), NULL);
+    }
+
+    /* --default-item: the cursor goes to the item, whichever list it is in */
+    set_default_row (GTK_TREE_VIEW(Xdialog.widget1), BUILDLIST_COL_ITEM);
+    set_default_row (GTK_TREE_VIEW(Xdialog.widget2), BUILDLIST_COL_ITEM);
+#endif
+
     set_timeout();
 }
 
@@ -1617,6 +2296,76 @@ void create_buildlist (gchar *optarg, gchar *options[], gint list_size)
 //                            create_menubox
 // ------------------------------------------------------------------------------------------
 
+#if GTK_CHECK_VERSION(2,0,0)
+static void menubox_cell_data (GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                               GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+{
+    listname *item;
+
+    gtk_tree_model_get (model, iter, MENUBOX_COL_ITEM, &item, -1);
+    g_object_set (renderer, "text",
+                  GPOINTER_TO_INT(data) == 0 ? item_tag(item) : item_name(item),
+                  NULL);
+}
+
+/* Type-ahead search: a typed tag is found at once through the tags index,
+ * otherwise the rows which tag (or name with --no-tags) starts with the
+ * typed text match.
+ */
+static gboolean menubox_search_equal (GtkTreeModel *model, gint column, const gchar *key,
+                                      GtkTreeIter *iter, gpointer data)
+{
+    listname *item;
+    gint i;
+
+    gtk_tree_model_get (model, iter, MENUBOX_COL_ITEM, &item, -1);
+    if ((i = find_list_item(key)) >= 0) {
+        return item != &Xdialog.array[i];    /* FALSE means "found" */
+    }
+    return g_ascii_strncasecmp (Xdialog.tags ? item_tag(item) : item_name(item),
+                                key, strlen(key)) != 0;
+}
+
+/* Adds the tag (field 0) or name (field 1) column, as wide as the widest of
+ * the "list_size" strings, all measured with a single layout: in pixels, as
+ * fewer bytes may be wider (proportional font, multibyte characters).
+ */
+static void set_menubox_column (GtkTreeView *treeview, const gchar *title, gint field,
+                                gint list_size, gboolean visible)
+{
+    GtkCellRenderer *renderer;
+    GtkTreeViewColumn *column;
+    PangoLayout *layout;
+    gint i, width, max_width = 0;
+
+    renderer = g_object_new (GTK_TYPE_CELL_RENDERER_TEXT,
+                             "xalign", 0.0,     /* justify left */
+                             NULL);
+    column = g_object_new (GTK_TYPE_TREE_VIEW_COLUMN,
+                           "title", title,
+                           NULL);
+    gtk_tree_view_column_pack_start (column, renderer, FALSE);
+    gtk_tree_view_column_set_cell_data_func (column, renderer, menubox_cell_data,
+                                             GINT_TO_POINTER(field), NULL);
+
+    if (visible) {
+        layout = gtk_widget_create_pango_layout (GTK_WIDGET(treeview), NULL);
+        for (i = 0; i < list_size; i++) {
+            pango_layout_set_text (layout, field == 0 ? item_tag(&Xdialog.array[i])
+                                                      : item_name(&Xdialog.array[i]), -1);
+            pango_layout_get_pixel_size (layout, &width, NULL);
+            max_width = MAX(max_width, width);
+        }
+        g_object_unref (G_OBJECT(layout));
+    }
+    gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_column_set_fixed_width (column, max_width + xmult);
+
+    gtk_tree_view_append_column (treeview, column);
+    gtk_tree_view_column_set_visible (column, visible);
+}
+#endif
+
 void create_menubox (gchar *optarg, gchar *options[], gint list_size)
 {
     GtkWidget *button_ok;
@@ -1628,7 +2377,6 @@ void create_menubox (gchar *optarg, gchar *options[], gint list_size)
     int params = 2 + Xdialog.tips;
 
     Xdialog_array(list_size);
-    Xdialog.array[0].state = -1;
 
     open_window();
 
@@ -1644,84 +2392,56 @@ void create_menubox (gchar *optarg, gchar *options[], gint list_size)
         Xdialog.widget1 = status_bar;
         gtk_container_add (GTK_CONTAINER(hbox), status_bar);
         Xdialog.status_id = gtk_statusbar_get_context_id (GTK_STATUSBAR(status_bar), "tips");
-        gtk_statusbar_push (GTK_STATUSBAR(status_bar), Xdialog.status_id,
-                            Xdialog.array[0].tips);
+        gtk_statusbar_push (GTK_STATUSBAR(status_bar), Xdialog.status_id, "");
     }
 
     button_ok = set_all_buttons(FALSE, TRUE);
 
 #if GTK_CHECK_VERSION(2,0,0)
-    GtkTreeModel     *tree_model;
     GtkTreeView      *treeview;
     GtkTreeSelection *tree_sel;
-    GtkTreeIter  iter;
     GtkListStore *store;
 
-    store = gtk_list_store_new (3,
-                                G_TYPE_STRING,   // tag
-                                G_TYPE_STRING,   // name
-                                G_TYPE_POINTER); // listname* (hidden)
-    tree_model = GTK_TREE_MODEL (store);
+    /* Fill the model in a single pass while it is not attached to the view:
+     * rows only hold the listname pointer, the strings being drawn from
+     * Xdialog.array by menubox_cell_data().
+     */
+    store = gtk_list_store_new (MENUBOX_NUM_COLS,
+                                G_TYPE_POINTER); // listname*
+    for (i = 0; i < list_size; i++)
+    {
+        set_list_item(i, options[params*i], options[params*i+1],
+                      Xdialog.tips == 1 ? options[params*i+2] : NULL);
+        gtk_list_store_insert_with_values (store, NULL, i,
+                                           MENUBOX_COL_ITEM, &Xdialog.array[i],
+                                           -1);
+    }
+    if ((i = find_list_item(Xdialog.default_item)) >= 0) {
+        rownum = i;  // found --default-item
+    }
+    Xdialog.array[0].state = rownum;
 
-    Xdialog.widget2 = gtk_tree_view_new_with_model (tree_model);
+    Xdialog.widget2 = gtk_tree_view_new_with_model (GTK_TREE_MODEL(store));
     treeview = GTK_TREE_VIEW (Xdialog.widget2);
-    gtk_container_add (GTK_CONTAINER(scrolled_window), GTK_WIDGET(treeview));
-
     g_object_unref (G_OBJECT(store));
     gtk_tree_view_set_headers_visible (treeview, FALSE);
 
     tree_sel = gtk_tree_view_get_selection (treeview);
     gtk_tree_selection_set_mode (tree_sel, GTK_SELECTION_BROWSE);
 
-    GtkCellRenderer *renderer;
-    GtkTreeViewColumn *column;
-
-    // column 0 - tag
-    renderer = g_object_new (GTK_TYPE_CELL_RENDERER_TEXT,
-                           "xalign", 0.0,     /* justify left */
-                           NULL);
-    column = g_object_new (GTK_TYPE_TREE_VIEW_COLUMN,
-                          "title",          "tag",
-                          NULL);
-    gtk_tree_view_column_pack_start (column, renderer, FALSE);
-    gtk_tree_view_column_add_attribute (column, renderer, "text", 0);
-    gtk_tree_view_append_column (treeview, column);
-    gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_AUTOSIZE);
-    if (!Xdialog.tags) {
-        gtk_tree_view_column_set_visible (column, FALSE);
-    }
+    // column 0 - tag, column 1 - name: fixed widths, taken from the widest
+    // strings, so that the rows are not measured again by the view
+    set_menubox_column (treeview, "tag", 0, list_size, Xdialog.tags);
+    set_menubox_column (treeview, "name", 1, list_size, TRUE);
+    gtk_tree_view_set_fixed_height_mode (treeview, TRUE);
 
-    // column 1 - name
-    renderer = g_object_new (GTK_TYPE_CELL_RENDERER_TEXT,
-                            "xalign", 0.0,
-                            NULL);
-    column = g_object_new (GTK_TYPE_TREE_VIEW_COLUMN,
-                           "title",          "name",
-                           NULL);
-    gtk_tree_view_column_pack_start (column, renderer, FALSE);
-    gtk_tree_view_column_add_attribute (column, renderer, "text", 1);
-    gtk_tree_view_append_column (treeview, column);
-    gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_AUTOSIZE);
-    //----
+    gtk_tree_view_set_search_column (treeview, MENUBOX_COL_ITEM);
+    gtk_tree_view_set_search_equal_func (treeview, menubox_search_equal, NULL, NULL);
 
-    for (i = 0; i < list_size; i++)
-    {
-        strncpy(Xdialog.array[i].tag, options[params*i], sizeof(Xdialog.array[i].tag));
-        strncpy(Xdialog.array[i].name, options[params*i+1], sizeof(Xdialog.array[i].name));
-        if (Xdialog.tips == 1) {
-            strncpy(Xdialog.array[i].tips, options[params*i+2], sizeof(Xdialog.array[i].tips));
-        }
-        gtk_list_store_append (store, &iter);
-        gtk_list_store_set (store, &iter,
-                            0, Xdialog.array[i].tag,
-                            1, Xdialog.array[i].name,
-                            2, &Xdialog.array[i],
-                            -1);
-        if (*Xdialog.default_item && !strcmp(Xdialog.default_item, Xdialog.array[i].tag)) {
-            rownum = i;  // found --default-item
-        }
+    gtk_container_add (GTK_CONTAINER(scrolled_window), GTK_WIDGET(treeview));
+    if (Xdialog.filter) {
+        set_list_filter (Xdialog.vbox, scrolled_window, treeview, MENUBOX_COL_ITEM, list_size);
     }
-    Xdialog.array[0].state = rownum;
 
     g_signal_connect (G_OBJECT (treeview),  "row_activated",
                       G_CALLBACK(on_menubox_treeview_row_activated_cb), NULL);
@@ -1760,30 +2480,26 @@ void create_menubox (gchar *optarg, gchar *options[], gint list_size)
 
     for (i = 0; i < list_size; i++)
     {
-        strncpy(Xdialog.array[i].tag, options[params*i], sizeof(Xdialog.array[i].tag));
-        strncpy(Xdialog.array[i].name, options[params*i+1], sizeof(Xdialog.array[i].name));
-        if (Xdialog.tips == 1) {
-            strncpy(Xdialog.array[i].tips, options[params*i+2], sizeof(Xdialog.array[i].tips));
-        }
+        set_list_item(i, options[params*i], options[params*i+1],
+                      Xdialog.tips == 1 ? options[params*i+2] : NULL);
         rownum = gtk_clist_append (clist, null_row);
 
-        if (strlen(Xdialog.array[i].tag) == 0) {
+        if (Xdialog.array[i].tag_len == 0) {
             gtk_clist_set_text (clist, rownum, 0, "~");
             gtk_clist_set_selectable (clist, rownum, FALSE);
             gtk_clist_set_foreground (clist, rownum, (GdkColor *) &GREY1);
             gtk_clist_set_background (clist, rownum, (GdkColor *) &GREY2);
         } else {
-            gtk_clist_set_text (clist, rownum, 0, Xdialog.array[i].tag);
+            gtk_clist_set_text (clist, rownum, 0, item_tag(&Xdialog.array[i]));
             gtk_clist_set_row_data (clist, rownum, (gpointer) &Xdialog.array[i]);
             if (selrow == -1) {
                 selrow = rownum; // first selectable row
             }
         }
-        gtk_clist_set_text (clist, rownum, 1, Xdialog.array[i].name);
-
-        if (*Xdialog.default_item && !strcmp(Xdialog.default_item, Xdialog.array[i].tag)) {
-            selrow = rownum; // found --default-item
-        }
+        gtk_clist_set_text (clist, rownum, 1, item_name(&Xdialog.array[i]));
+    }
+    if ((i = find_list_item(Xdialog.default_item)) >= 0) {
+        selrow = i; // found --default-item (rows and items match)
     }
 
     gtk_clist_columns_autosize (clist);
@@ -1815,16 +2531,61 @@ void create_menubox (gchar *optarg, gchar *options[], gint list_size)
 //                            create_treeview
 // ------------------------------------------------------------------------------------------
 
+#if GTK_CHECK_VERSION(2,0,0)
+/* The treeview rows being added as their parent is expanded (see
+ * tree_add_children()), expands the ancestors of "item" so that its row
+ * exists, and returns the path of this row.
+ */
+static GtkTreePath *reveal_tree_item (GtkTreeView *treeview, gint item)
+{
+    GtkTreeModel *model = gtk_tree_view_get_model (treeview);
+    GtkTreePath *path;
+    GtkTreeIter iter, parent;
+    listname *rowdata;
+    gint *ancestors, n = 0, i;
+    gboolean valid;
+
+    for (i = item; i >= 0; i = Xdialog.tree_parent[i]) {
+        n++;
+    }
+    ancestors = g_new (gint, n);
+    for (i = item; i >= 0; i = Xdialog.tree_parent[i]) {
+        ancestors[--n] = i;
+    }
+
+    /* from the root down to the item row */
+    for (valid = gtk_tree_model_get_iter_first (model, &iter); valid; ) {
+        gtk_tree_model_get (model, &iter, 1, &rowdata, -1);
+        if (rowdata != &Xdialog.array[ancestors[n]]) {
+            valid = gtk_tree_model_iter_next (model, &iter);
+            continue;
+        }
+        if (ancestors[n] == item) {
+            break;
+        }
+        path = gtk_tree_model_get_path (model, &iter);
+        gtk_tree_view_expand_row (treeview, path, FALSE);
+        gtk_tree_path_free (path);
+        parent = iter;
+        valid = gtk_tree_model_iter_children (model, &iter, &parent);
+        n++;
+    }
+    g_free (ancestors);
+    return valid ? gtk_tree_model_get_path (model, &iter) : NULL;
+}
+#endif
+
 void create_treeview (gchar *optarg, gchar *options[], gint list_size)
 {
     GtkWidget *scrolled_window;
     GtkWidget *button_ok;
-    int depth = 0;
+    int base = 0, depth = 0, prev_depth = 0;
     int i;
     int params = 4 + Xdialog.tips;
     char *status;
 
     Xdialog_array(list_size);
+    Xdialog_tree(list_size);
 
     open_window();
 
@@ -1838,62 +2599,56 @@ void create_treeview (gchar *optarg, gchar *options[], gint list_size)
     /* Create the tree view in a scrolled window */
     scrolled_window = set_scrolled_window(Xdialog.vbox, xmult/2, -1, list_size, 4);
 
+    /* Link the items to their parent and siblings, the depths being taken
+     * from the one of the first item */
+    for (i = 0 ; i < list_size ; i++)
+    {
+        set_list_item(i, options[params*i], options[params*i+1], NULL);
+        if (i == 0) {
+            base = atoi(options[params*i+3]);
+        }
+        depth = MAX(atoi(options[params*i+3]) - base, 0);
+        if (!set_tree_item(i, depth, prev_depth)) {
+            fprintf(stderr,
+                XDIALOG": You cannot increment the --treeview depth "\
+                "by more than one level each time !  Aborting...\n");
+            xdialog_exit(255);
+        }
+        prev_depth = depth;
+    }
+
 #if GTK_CHECK_VERSION(2,0,0)
     GtkTreeStore *store;
     GtkTreeViewColumn *column;
     GtkCellRenderer *renderer;
-    GtkTreeIter tree_iter[MAX_TREE_DEPTH];
-    GtkTreeIter selected_iter;
     GtkTreeSelection *tree_sel;
+    GtkTreePath *path;
     GtkWidget *tree;
-    gboolean set_default_item = FALSE;
+    gint selected = -1;
 
-    /* Fill the store with the data */
-    store = gtk_tree_store_new (2,
-                                G_TYPE_STRING,   // name
-                                G_TYPE_POINTER); // listname* (hidden)
-    for (i = 0 ; i < list_size ; i++)
+    for (i = 0 ; i < list_size && selected < 0 ; i++)
     {
-        strncpy(Xdialog.array[i].tag, options[params*i], sizeof(Xdialog.array[i].tag));
-        strncpy(Xdialog.array[i].name, options[params*i+1], sizeof(Xdialog.array[i].name));
         status = options[params*i+2];
-        Xdialog.array[i].state = 0;
-
-        depth = atoi(options[params*i+3]);
-
-        if (depth > MAX_TREE_DEPTH) {
-            fprintf(stderr,
-                "Xdialog: Max allowed depth for "\
-                "--treeview is %d !  Aborting...\n",
-                MAX_TREE_DEPTH);
-            exit(255);
+        if (item_status(NULL, status, options[params*i]) == 1) {
+            selected = i;
         }
+    }
 
-        if (depth == 0) {
-            gtk_tree_store_append (store, &tree_iter[0], NULL);
-            gtk_tree_store_set (store, &tree_iter[0],
-                                0, Xdialog.array[i].name,
-                                1, &Xdialog.array[i],
-                                -1);
-        } else {
-            gtk_tree_store_append (store,
-                                   &tree_iter[depth],
-                                   &tree_iter[depth-1]);
-            gtk_tree_store_set (store, &tree_iter[depth],
-                                0, Xdialog.array[i].name,
-                                1, &Xdialog.array[i],
-                                -1);
-        }
-        if (item_status(NULL, status, Xdialog.array[i].tag) == 1 && !set_default_item) {
-            set_default_item = TRUE;
-            selected_iter = tree_iter[depth];
-        }
+    /* Only the root rows are added now, the others as their parent row is
+     * expanded (see tree_test_expand_row()) */
+    store = gtk_tree_store_new (2,
+                                G_TYPE_STRING,   // name
+                                G_TYPE_POINTER); // listname* (hidden)
+    if (list_size > 0) {
+        tree_add_children (store, NULL, 0);
     }
 
     tree = gtk_tree_view_new_with_model(GTK_TREE_MODEL (store));
     Xdialog.widget1 = tree;
     g_object_unref (G_OBJECT (store));
     gtk_tree_view_set_headers_visible (GTK_TREE_VIEW(tree), FALSE);
+    g_signal_connect (G_OBJECT(tree), "test-expand-row",
+                      G_CALLBACK(tree_test_expand_row), NULL);
 
     /* Setup the selection handler - currently not used... */
     tree_sel = gtk_tree_view_get_selection (GTK_TREE_VIEW(tree));
@@ -1909,84 +2664,63 @@ void create_treeview (gchar *optarg, gchar *options[], gint list_size)
 
     gtk_container_add (GTK_CONTAINER(scrolled_window), tree);
 
-    /// expand root node
-    //GtkTreePath  *rpath = gtk_tree_path_new_from_string ("0");
-    //gtk_tree_view_expand_row (GTK_TREE_VIEW(tree), rpath, FALSE);
-    //gtk_tree_path_free (rpath);
-
-    /// must expand all nodes for the selection to take effect
-    gtk_tree_view_expand_all (GTK_TREE_VIEW(tree));
-
-    if (set_default_item) {
-        gtk_tree_selection_select_iter (tree_sel, &selected_iter);
+    /// only the ancestors of the selected and --default-item rows are expanded
+    if (selected >= 0 && (path = reveal_tree_item (GTK_TREE_VIEW(tree), selected)) != NULL) {
+        gtk_tree_selection_select_path (tree_sel, path);
+        gtk_tree_path_free (path);
+    }
+    i = find_list_item (Xdialog.default_item);
+    if (i >= 0 && (path = reveal_tree_item (GTK_TREE_VIEW(tree), i)) != NULL) {
+        gtk_tree_view_set_cursor (GTK_TREE_VIEW(tree), path, NULL, FALSE);
+        gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW(tree), path, NULL, TRUE, 0.5, 0.5);
+        gtk_tree_path_free (path);
     }
 #else // -- GTK1 --
 
     GtkWidget *item;
     GtkWidget *selected = NULL;
+    GtkWidget **items;
     GtkTree *tree;
-    GtkTree *oldtree[MAX_TREE_DEPTH];
     GtkWidget *subtree;
-    int level;
+    gint parent;
 
     Xdialog.widget1 = gtk_tree_new();
     gtk_widget_show (Xdialog.widget1);
     gtk_scrolled_window_add_with_viewport (GTK_SCROLLED_WINDOW(scrolled_window),
                                            Xdialog.widget1);
 
-    tree = oldtree[0] = GTK_TREE(Xdialog.widget1);
+    tree = GTK_TREE(Xdialog.widget1);
 
     gtk_tree_set_view_mode (tree, GTK_TREE_VIEW_ITEM);
     gtk_tree_set_selection_mode (tree, GTK_SELECTION_BROWSE);
 
+    items = g_new (GtkWidget *, list_size);
     for (i = 0 ; i < list_size ; i++)
     {
-        strncpy (Xdialog.array[i].tag, options[params*i], sizeof(Xdialog.array[i].tag));
-        strncpy (Xdialog.array[i].name, options[params*i+1], sizeof(Xdialog.array[i].name));
         status = options[params*i+2];
 
-        item = gtk_tree_item_new_with_label (Xdialog.array[i].name);
+        item = items[i] = gtk_tree_item_new_with_label (item_name(&Xdialog.array[i]));
         g_object_set_data (G_OBJECT(item), "listitem", (gpointer) &Xdialog.array[i]);
 
-        level = atoi(options[params*i+3]);
-        if (i > 0) {
-            if (atoi(options[params*(i-1)+3]) > level) {
-                depth = level;
-                tree = oldtree[level];
-            }
+        /* the subtree of the parent item is set up with its first child */
+        parent = Xdialog.tree_parent[i];
+        if (parent < 0) {
+            tree = GTK_TREE(Xdialog.widget1);
+        } else if (GTK_TREE_ITEM(items[parent])->subtree == NULL) {
+            subtree = gtk_tree_new();
+            g_signal_connect (G_OBJECT(subtree), "button_press_event",
+                              G_CALLBACK(double_click_event),
+                              button_ok);
+            gtk_tree_item_set_subtree(GTK_TREE_ITEM(items[parent]), subtree);
+            tree = GTK_TREE(subtree);
+            gtk_tree_set_selection_mode (tree, GTK_SELECTION_BROWSE);
+        } else {
+            tree = GTK_TREE(GTK_TREE_ITEM(items[parent])->subtree);
         }
 
         gtk_tree_append(tree, item);
 
-        if (i+1 < list_size)
-        {
-            if (level < atoi(options[params*(i+1)+3])) {
-                if (atoi(options[params*(i+1)+3]) != level + 1) {
-                    fprintf(stderr,
-                        "Xdialog: You cannot increment the --treeview depth "\
-                        "by more than one level each time !  Aborting...\n");
-                        exit(255);
-                }
-                subtree = gtk_tree_new();
-                g_signal_connect (G_OBJECT(subtree), "button_press_event",
-                                  G_CALLBACK(double_click_event),
-                                  button_ok);
-                gtk_tree_item_set_subtree(GTK_TREE_ITEM(item), subtree);
-                depth++;
-                if (depth > MAX_TREE_DEPTH) {
-                    fprintf(stderr,
-                        "Xdialog: Max allowed depth for "\
-                        "--treeview is %d !  Aborting...\n",
-                        MAX_TREE_DEPTH);
-                        exit(255);
-                }
-                tree = GTK_TREE(subtree);
-                oldtree[depth] = tree;
-                gtk_tree_set_selection_mode (tree, GTK_SELECTION_BROWSE);
-            }
-        }
-
-        if (!selected && item_status(item, status, Xdialog.array[i].tag) == 1) {
+        if (!selected && item_status(item, status, options[params*i]) == 1) {
             selected = item;
             Xdialog.array[0].state = i;
         }
@@ -1996,6 +2730,7 @@ void create_treeview (gchar *optarg, gchar *options[], gint list_size)
             gtk_widget_set_tooltip_text (item, (gchar *) options[params*i+4]);
         }
     }
+    g_free (items);
 
     g_signal_connect (G_OBJECT(Xdialog.widget1), "selection_changed",
                       G_CALLBACK(tree_selection_changed), NULL);
@@ -2436,9 +3171,9 @@ void create_calendar(gchar *optarg, gint day, gint month, gint year)
     g_signal_connect_after(G_OBJECT(Xdialog.widget1), "day_selected_double_click",
                       G_CALLBACK(exit_ok), NULL);
 
-    if (Xdialog.interval > 0) {
-        Xdialog.timer = g_timeout_add(Xdialog.interval, calendar_timeout, NULL);
-    }
+    watch_changes(Xdialog.widget1, "day_selected");
+    watch_changes(Xdialog.widget1, "month_changed");
+    set_interval(calendar_timeout);
     set_timeout();
 }
 
@@ -2473,9 +3208,10 @@ void create_timebox(gchar *optarg, gint hours, gint minutes, gint seconds)
     button_ok = set_all_buttons(FALSE, TRUE);
     g_signal_connect (G_OBJECT(button_ok), "clicked", G_CALLBACK(timebox_exit), NULL);
 
-    if (Xdialog.interval > 0) {
-        Xdialog.timer = g_timeout_add(Xdialog.interval, timebox_timeout, NULL);
-    }
+    watch_changes(Xdialog.widget1, "value_changed");
+    watch_changes(Xdialog.widget2, "value_changed");
+    watch_changes(Xdialog.widget3, "value_changed");
+    set_interval(timebox_timeout);
     set_timeout();
 }
 
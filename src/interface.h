@@ -12,13 +12,18 @@
 #define HIGH_DIALOG_COMPAT	"XDIALOG_HIGH_DIALOG_COMPAT"
 #define FORCE_AUTOSIZE		"XDIALOG_FORCE_AUTOSIZE"
 #define INFOBOX_TIMEOUT		"XDIALOG_INFOBOX_TIMEOUT"
+#define TRACE_FILE		"XDIALOG_TRACE"
+#define STATS_ENV		"XDIALOG_STATS"
+#define WATCHDOG_FILE		"XDIALOG_WATCHDOG"
+#define WATCHDOG_THRESHOLD_MS	"XDIALOG_WATCHDOG_MS"
                                 /* Temporary pipe filename used for printing */
 #define TEMP_FILE               "/tmp/Xdialog.tmp"
 
 /* You may change these as well IOT change the Xdialog limitations... */
 
-#define MAX_TREE_DEPTH 24
 #define MAX_LABEL_LENGTH 2048
+#define COMBOBOX_LARGE_LIST 1000	/* items over which the combo popup menu is replaced */
+#define COMBOBOX_MAX_COMPLETIONS 200	/* completion rows for a large combobox */
 #define MAX_INPUT_DEFAULT_LENGTH 1024
 #define MAX_BUTTON_LABEL_LENGTH 32
 #define MAX_TITLE_LENGTH 64
@@ -30,6 +35,7 @@
 #define MAX_FILENAME_LENGTH 256
 #define MAX_PRTNAME_LENGTH 64
 #define MAX_PRTCMD_LENGTH MAX_PRTNAME_LENGTH+32
+#define PRINT_CHUNK_SIZE 65536		/* Segment size when streaming text to the printer */
 
 /* The following defines should be changed via the "configure" options, type:
  *    ./configure --help
@@ -69,11 +75,17 @@
 #define PRINT _("_Print")
 #define ADD _("_Add")
 #define REMOVE _("_Remove")
+#define ADD_ALL _("Add a_ll")
+#define REMOVE_ALL _("Remo_ve all")
 #define TIME_FRAME_LABEL _("Hours : Minutes : Seconds")
 #define TIME_STAMP _("Time stamp")
 #define DATE_STAMP _("Date - Time")
 #define LOG_MESSAGE _("Log message")
 #define HIDE_TYPING _("Hide typing")
+#define PRINT_STARTED _("Printing...")
+#define PRINT_PROGRESS _("Printing... %d%%")
+#define PRINT_DONE _("Printed")
+#define PRINT_FAILED _("Printing failed")
 
 /* The following defines should not be changed. */
 
@@ -88,6 +100,11 @@
 #define ICON_ONLY 0
 #define TEXT_ONLY 1
 
+/* Results output formats (--output-format) */
+#define OUTPUT_TEXT 0
+#define OUTPUT_NUL 1
+#define OUTPUT_JSON 2
+
 #define RADIOLIST 1
 #define CHECKLIST 2
 
@@ -103,20 +120,52 @@ typedef enum
 	LOGBOX_NUM_COLS
 } LOGBOX_COL;
 
+typedef enum
+{
+	ITEMLIST_COL_INDEX,
+	ITEMLIST_COL_SENSITIVE,
+	ITEMLIST_NUM_COLS
+} ITEMLIST_COL;
+
+typedef enum
+{
+	MENUBOX_COL_ITEM,
+	MENUBOX_NUM_COLS
+} MENUBOX_COL;
+
+typedef enum
+{
+	BUILDLIST_COL_NAME,
+	BUILDLIST_COL_ITEM,
+	BUILDLIST_NUM_COLS
+} BUILDLIST_COL;
+
+/* buildlist_add_or_remove() flags */
+#define BUILDLIST_REMOVE	(1 << 0)
+#define BUILDLIST_ALL		(1 << 1)
+
 /* Structure definitions. */
 
 typedef struct {
 	gint state;
-	gchar tag[MAX_ITEM_LENGTH];
-	gchar name[MAX_ITEM_LENGTH];
-	gchar tips[MAX_ITEM_LENGTH];
+	guint tag, tag_len;		/* offsets and lengths in Xdialog.list_strings */
+	guint name, name_len;
+	guint tips, tips_len;
 } listname;
 
+/* List item strings accessors (see Xdialog_array() in support.c).  Their
+ * address may change when set_list_item() is called.
+ */
+#define list_string(offset)	((const gchar *) Xdialog.list_strings->data + (offset))
+#define item_tag(item)		list_string((item)->tag)
+#define item_name(item)		list_string((item)->name)
+#define item_tips(item)		list_string((item)->tips)
+
 typedef struct	{
 	gchar		title[MAX_TITLE_LENGTH];		/* Xdialog window title */
 	gchar		backtitle[MAX_BACKTITLE_LENGTH];	/* Backtitle label */
 	gchar		wmclass[MAX_WMCLASS_LENGTH];		/* Xdialog wmclass name */
-	gchar		label_text[MAX_LABEL_LENGTH];		/* New label text (for infobox and gauge) */
+	GString		*label_text;			/* New label text (for infobox, gauge and progress) */
 	gchar		check_label[MAX_CHECK_LABEL_LENGTH];	/* Check button label text */
 	gchar		ok_label[MAX_BUTTON_LABEL_LENGTH];	/* OK button label text */
 	gchar		cancel_label[MAX_BUTTON_LABEL_LENGTH];	/* CANCEL button label text */
@@ -132,6 +181,8 @@ typedef struct	{
 	gint		justify;				/* Xdialog labels justification method */
 	gint		buttons_style;				/* Xdialog buttons style */
 	gint		interval;				/* Xdialog output result time interval */
+	gboolean	report_changes;				/* TRUE to report the results as they change */
+	gboolean	report_sequence;			/* TRUE to number the above reports */
 	gint		timeout;				/* Xdialog user input timeout (in seconds) */
 	gint		timer;					/* Xdialog timer routine */
 	gint		timer2;					/* Xdialog timer routine #2 (for user timeout) */
@@ -164,6 +215,7 @@ typedef struct	{
 	gboolean	keep_colors;				/* TRUE to remember colors in logbox */
 	gboolean	ignore_eof;				/* TRUE to ignore EOF in infobox/gauge */
 	gboolean	smooth;					/* logbox - ignored */
+	gboolean	filter;					/* TRUE to setup a filter entry in menu/list */
 	GtkWidget *	window;
 	GtkBox *	vbox;
 	GtkWidget *	widget1;
@@ -172,14 +224,22 @@ typedef struct	{
 	GtkWidget *	widget4;
 	guint		status_id;
 	FILE *		output;
+	gint		output_format;				/* Format of the results (OUTPUT_*) */
 	FILE *		file;
 	long		file_init_size;				/* for logbox and tailbox */
 	char		icon_file[MAX_FILENAME_LENGTH];
 	char		rc_file[MAX_FILENAME_LENGTH];
 	char		printer[MAX_PRTNAME_LENGTH];
+	gchar *		print_file;				/* File shown in the textbox (printed as is if unmodified) */
+	gchar *		items_from;				/* --items-from file ("-" for stdin) */
+	GPtrArray *	items;					/* List parameters read from items_from */
+	GStringChunk *	items_chunk;				/* Storage for the above */
 	int		exit_code;
 	gdouble		progress_step; /* --progress */
 	listname *	array;
+	GByteArray *	list_strings;				/* Strings of the array items */
+	gint *		tree_parent;				/* Parent index of the treeview items (-1 for the roots) */
+	gint *		tree_next;				/* Next sibling index of the treeview items (or -1) */
 } Xdialog_data;
 
 
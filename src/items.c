@@ -0,0 +1,438 @@
+/*
+ * List items reading for Xdialog (--items-from option).
+ *
+ * The items of the combo, menu and list boxes may be read from a file (or
+ * from stdin) instead of the command line, so that long lists are not bound
+ * by the command line length limit.  The record format is guessed from the
+ * first bytes of the file:
+ *
+ *  - NUL terminated fields, just like the command line parameters (e.g. the
+ *    output of "printf '%s\0' ..."),
+ *  - JSON lines: one JSON array per line, or one JSON object with "tag",
+ *    "item", "status", "depth" and "help" members (provided the first line
+ *    parses as such),
+ *  - TSV: one record per line, with tab separated fields in which "\t",
+ *    "\n" and "\\" stand for a tab, a linefeed and a backslash.
+ *
+ * Missing trailing fields in a JSON or TSV record are left empty.  The file
+ * is parsed while it is read, and all the fields are stored into a single
+ * GStringChunk, the parameters array being a GPtrArray of pointers into it.
+ */
+
+#include "common.h"
+
+#include <errno.h>
+
+#include "interface.h"
+#include "support.h"
+
+/* Global structures and variables */
+extern Xdialog_data Xdialog;
+
+#define ITEMS_BUFFER_SIZE 65536
+#define MAX_ITEM_FIELDS   8    /* more than the treeview ones */
+
+typedef enum {
+    ITEMS_NUL,
+    ITEMS_TSV,
+    ITEMS_JSON
+} items_format;
+
+typedef struct {
+    const gchar *path;
+    const gchar * const *names;    /* field names, for the JSON objects */
+    gint parameters;               /* fields per record */
+    gint count;                    /* fields in the current record */
+    gint line;
+    gboolean escape;               /* TSV backslash pending */
+    gboolean quiet;                /* no error messages (format guess) */
+    GString *field;
+    GStringChunk *chunk;
+    GPtrArray *items;
+} items_parser;
+
+static gboolean items_error(items_parser *p, const gchar *message)
+{
+    if (!p->quiet)
+        fprintf(stderr, XDIALOG": %s, line %d: %s\n", p->path, p->line, message);
+    return FALSE;
+}
+
+static gboolean add_field(items_parser *p)
+{
+    if (p->count == p->parameters)
+        return items_error(p, "too many fields in record");
+    g_ptr_array_add(p->items,
+                    g_string_chunk_insert_len(p->chunk, p->field->str,
+                                              p->field->len));
+    g_string_truncate(p->field, 0);
+    p->count++;
+    return TRUE;
+}
+
+/* Ends a JSON or TSV record, padding it with empty fields */
+static void end_record(items_parser *p)
+{
+    if (p->count == 0)
+        return;
+    while (p->count < p->parameters) {
+        g_ptr_array_add(p->items, g_string_chunk_insert_const(p->chunk, ""));
+        p->count++;
+    }
+    p->count = 0;
+}
+
+static gboolean parse_tsv(items_parser *p, const gchar *buffer, gsize length)
+{
+    gsize i;
+    gchar c;
+
+    for (i = 0; i < length; i++) {
+        c = buffer[i];
+        if (p->escape) {
+            p->escape = FALSE;
+            g_string_append_c(p->field, c == 't' ? '\t' : c == 'n' ? '\n' : c);
+        } else if (c == '\\') {
+            p->escape = TRUE;
+        } else if (c == '\t') {
+            if (!add_field(p))
+                return FALSE;
+        } else if (c == '\n') {
+            if (p->field->len > 0 && p->field->str[p->field->len-1] == '\r')
+                g_string_truncate(p->field, p->field->len - 1);
+            if ((p->count > 0 || p->field->len > 0) && !add_field(p))
+                return FALSE;
+            end_record(p);
+            p->line++;
+        } else {
+            g_string_append_c(p->field, c);
+        }
+    }
+    return TRUE;
+}
+
+static gboolean parse_nul(items_parser *p, const gchar *buffer, gsize length)
+{
+    const gchar *end;
+    gsize i, n;
+
+    for (i = 0; i < length; i += n + 1) {
+        end = memchr(buffer + i, '\0', length - i);
+        n = (end != NULL ? end : buffer + length) - (buffer + i);
+        g_string_append_len(p->field, buffer + i, n);
+        if (end == NULL)
+            break;
+        g_ptr_array_add(p->items,
+                        g_string_chunk_insert_len(p->chunk, p->field->str,
+                                                  p->field->len));
+        g_string_truncate(p->field, 0);
+    }
+    return TRUE;
+}
+
+static gboolean json_hex(const gchar *s, gunichar *u)
+{
+    gint i;
+
+    *u = 0;
+    for (i = 0; i < 4; i++) {
+        if (!g_ascii_isxdigit(s[i]))
+            return FALSE;
+        *u = (*u << 4) | g_ascii_xdigit_value(s[i]);
+    }
+    return TRUE;
+}
+
+/* Parses the JSON value at *s into the field buffer: strings are unescaped,
+ * true and false give "on" and "off" (for the status fields), null gives an
+ * empty field and numbers are kept as they are.
+ */
+static gboolean json_value(items_parser *p, const gchar **s)
+{
+    const gchar *c = *s, *start;
+    gunichar u, low;
+
+    g_string_truncate(p->field, 0);
+    if (*c == '"') {
+        for (c++; *c != '"'; c++) {
+            if (*c == '\0')
+                return FALSE;
+            if (*c != '\\') {
+                g_string_append_c(p->field, *c);
+                continue;
+            }
+            switch (*++c) {
+                case 'b': g_string_append_c(p->field, '\b'); break;
+                case 'f': g_string_append_c(p->field, '\f'); break;
+                case 'n': g_string_append_c(p->field, '\n'); break;
+                case 'r': g_string_append_c(p->field, '\r'); break;
+                case 't': g_string_append_c(p->field, '\t'); break;
+                case '"':
+                case '\\':
+                case '/': g_string_append_c(p->field, *c); break;
+                case 'u':
+                    if (!json_hex(c + 1, &u))
+                        return FALSE;
+                    c += 4;
+                    if (u >= 0xd800 && u < 0xdc00 && c[1] == '\\' && c[2] == 'u' &&
+                        json_hex(c + 3, &low) && low >= 0xdc00 && low < 0xe000) {
+                        u = 0x10000 + ((u - 0xd800) << 10) + (low - 0xdc00);
+                        c += 6;
+                    }
+                    g_string_append_unichar(p->field, u);
+                    break;
+                default:
+                    return FALSE;
+            }
+        }
+        c++;
+    } else {
+        for (start = c; *c != '\0' && *c != ',' && *c != ']' && *c != '}' &&
+                        !g_ascii_isspace(*c); c++);
+        if (c == start)
+            return FALSE;
+        if (c - start == 4 && strncmp(start, "true", 4) == 0)
+            g_string_append(p->field, "on");
+        else if (c - start == 5 && strncmp(start, "false", 5) == 0)
+            g_string_append(p->field, "off");
+        else if (c - start != 4 || strncmp(start, "null", 4) != 0)
+            g_string_append_len(p->field, start, c - start);
+    }
+    *s = c;
+    return TRUE;
+}
+
+#define skip_spaces(s) while (g_ascii_isspace(*(s))) (s)++
+
+static gboolean parse_json_line(items_parser *p, const gchar *s)
+{
+    gchar *values[MAX_ITEM_FIELDS];
+    const gchar *error = NULL;
+    gchar close;
+    gint i, n;
+
+    skip_spaces(s);
+    if (*s == '\0')
+        return TRUE;
+    if (*s != '[' && *s != '{')
+        return items_error(p, "JSON array or object expected");
+    close = (*s++ == '[' ? ']' : '}');
+    memset(values, 0, sizeof(values));
+
+    for (n = 0; error == NULL; n++) {
+        skip_spaces(s);
+        if (*s == close && n == 0)
+            break;
+        i = p->parameters;
+        if (close == '}') {    /* "name": value member */
+            if (*s != '"' || !json_value(p, &s)) {
+                error = "bad JSON member name";
+                break;
+            }
+            for (i = 0; i < p->parameters; i++)
+                if (strcmp(p->field->str, p->names[i]) == 0)
+                    break;
+            skip_spaces(s);
+            if (*s++ != ':') {
+                error = "':' expected";
+                break;
+            }
+            skip_spaces(s);
+        }
+        if (!json_value(p, &s)) {
+            error = "bad JSON value";
+            break;
+        }
+        if (close == ']') {
+            if (!add_field(p))
+                return FALSE;
+        } else if (i < p->parameters) {    /* unknown members are ignored */
+            g_free(values[i]);
+            values[i] = g_strndup(p->field->str, p->field->len);
+        }
+        skip_spaces(s);
+        if (*s == close)
+            break;
+        if (*s++ != ',')
+            error = "',' expected";
+    }
+    if (error == NULL) {
+        s++;
+        skip_spaces(s);
+        if (*s != '\0')
+            error = "trailing characters after the JSON record";
+    }
+
+    if (close == '}') {
+        for (i = 0; i < p->parameters; i++) {
+            g_string_assign(p->field, values[i] != NULL ? values[i] : "");
+            g_free(values[i]);
+            if (error == NULL)
+                add_field(p);
+        }
+    }
+    if (error != NULL)
+        return items_error(p, error);
+    end_record(p);
+    return TRUE;
+}
+
+static gboolean parse_json(items_parser *p, const gchar *buffer, gsize length)
+{
+    GString *line = p->field;
+    const gchar *end;
+    gchar *text;
+    gsize i, n;
+    gboolean ok;
+
+    /* The field buffer holds the pending line between reads */
+    for (i = 0; i < length; i += n + 1) {
+        end = memchr(buffer + i, '\n', length - i);
+        n = (end != NULL ? end : buffer + length) - (buffer + i);
+        g_string_append_len(line, buffer + i, n);
+        if (end == NULL)
+            break;
+        text = g_strndup(line->str, line->len);
+        ok = parse_json_line(p, text);
+        g_string_truncate(line, 0);
+        g_free(text);
+        if (!ok)
+            return FALSE;
+        p->line++;
+    }
+    return TRUE;
+}
+
+/* Whether the "length" first bytes of the file start with a JSON record: when
+ * its first line is complete, it must parse as one (a TSV field may well
+ * start with a bracket).
+ */
+static gboolean json_sniff(items_parser *p, const gchar *buffer, gsize length)
+{
+    items_parser check;
+    const gchar *end;
+    gchar *line;
+    gsize i;
+    gboolean ok;
+
+    for (i = 0; i < length && g_ascii_isspace(buffer[i]); i++);
+    if (i == length || (buffer[i] != '[' && buffer[i] != '{'))
+        return FALSE;
+    if ((end = memchr(buffer + i, '\n', length - i)) == NULL)
+        return TRUE;
+
+    memset(&check, 0, sizeof(check));
+    check.names = p->names;
+    check.parameters = p->parameters;
+    check.quiet = TRUE;
+    check.field = g_string_new(NULL);
+    check.chunk = g_string_chunk_new(256);
+    check.items = g_ptr_array_new();
+    line = g_strndup(buffer + i, end - (buffer + i));
+    ok = parse_json_line(&check, line);
+    g_free(line);
+    g_string_free(check.field, TRUE);
+    g_string_chunk_free(check.chunk);
+    g_ptr_array_free(check.items, TRUE);
+    return ok;
+}
+
+/* Releases the items read by read_items() */
+void free_items(void)
+{
+    if (Xdialog.items != NULL) {
+        g_ptr_array_free(Xdialog.items, TRUE);
+        Xdialog.items = NULL;
+    }
+    if (Xdialog.items_chunk != NULL) {
+        g_string_chunk_free(Xdialog.items_chunk);
+        Xdialog.items_chunk = NULL;
+    }
+}
+
+/* Reads the list items from the "path" file ("-" for stdin), each of them
+ * being made of "parameters" fields named after "names" (for the JSON
+ * objects).  The fields are put into Xdialog.items and the number of items
+ * is returned (or -1 on error).
+ */
+gint read_items(const gchar *path, gint parameters, const gchar * const *names)
+{
+    items_parser parser;
+    items_format format = ITEMS_TSV;
+    gchar *buffer;
+    gsize length;
+    gboolean ok = TRUE, first = TRUE;
+    FILE *file;
+
+    free_items();
+
+    if (strcmp(path, "-") == 0)
+        file = stdin;
+    else if ((file = fopen(path, "r")) == NULL) {
+        fprintf(stderr, XDIALOG": can't open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    memset(&parser, 0, sizeof(parser));
+    parser.path = path;
+    parser.names = names;
+    parser.parameters = parameters;
+    parser.line = 1;
+    parser.field = g_string_sized_new(MAX_ITEM_LENGTH);
+    parser.chunk = g_string_chunk_new(ITEMS_BUFFER_SIZE);
+    parser.items = g_ptr_array_sized_new(1024);
+    buffer = g_malloc(ITEMS_BUFFER_SIZE);
+
+    while (ok && (length = fread(buffer, 1, ITEMS_BUFFER_SIZE, file)) > 0) {
+        if (first) {
+            first = FALSE;
+            if (memchr(buffer, '\0', length) != NULL)
+                format = ITEMS_NUL;
+            else if (json_sniff(&parser, buffer, length))
+                format = ITEMS_JSON;
+        }
+        switch (format) {
+            case ITEMS_NUL:
+                ok = parse_nul(&parser, buffer, length);
+                break;
+            case ITEMS_JSON:
+                ok = parse_json(&parser, buffer, length);
+                break;
+            default:
+                ok = parse_tsv(&parser, buffer, length);
+        }
+    }
+    if (ok && ferror(file)) {
+        fprintf(stderr, XDIALOG": can't read %s: %s\n", path, strerror(errno));
+        ok = FALSE;
+    }
+
+    /* Last record without a trailing separator (maybe ending with a tab) */
+    if (ok && (parser.field->len > 0 || parser.count > 0)) {
+        parser.escape = FALSE;    /* a trailing backslash is dropped */
+        if (format == ITEMS_NUL)
+            ok = parse_nul(&parser, "", 1);
+        else if (format == ITEMS_JSON)
+            ok = parse_json(&parser, "\n", 1);
+        else
+            ok = parse_tsv(&parser, "\n", 1);
+    }
+    if (ok && format == ITEMS_NUL && parser.items->len % parameters != 0) {
+        fprintf(stderr, XDIALOG": %s: incorrect number of parameters in list\n",
+                path);
+        ok = FALSE;
+    }
+
+    g_free(buffer);
+    g_string_free(parser.field, TRUE);
+    if (file != stdin)
+        fclose(file);
+
+    Xdialog.items = parser.items;
+    Xdialog.items_chunk = parser.chunk;
+    if (!ok) {
+        free_items();
+        return -1;
+    }
+    return Xdialog.items->len / parameters;
+}
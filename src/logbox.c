@@ -0,0 +1,268 @@
+/*
+ * Logbox input (--logbox).
+ *
+ * The lines of the logged file are read by a reader thread, which blocks on
+ * the input descriptor, strips the "ESC[1;...m" colour sequences into row
+ * colours and stamps the lines (--time-stamp, --date-stamp).  The prepared
+ * rows are handed to the GTK+ thread through a single producer, single
+ * consumer ring (no lock: each side only moves its own index), and
+ * logbox_timeout() merely inserts them into the list, a frame worth at a
+ * time.  When the ring is full, the reader waits for the list to catch up,
+ * the data being left into the pipe or the file.  A last line without a
+ * linefeed is shown at the end of the initial contents of the file, or when
+ * the pipe is closed; past that, the reader waits for the end of the lines.
+ *
+ * Without thread support (GLib < 2.32, GTK+ 1.2), logbox_next() reads and
+ * parses the lines itself, from logbox_timeout().
+ */
+
+#include "common.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+
+#include "interface.h"
+#include "support.h"
+
+/* Global structures and variables */
+extern Xdialog_data Xdialog;
+
+#define LOGBOX_RING  4096      /* rows, a power of 2 */
+#define LOGBOX_POLL  100       /* reader thread stop check period (ms) */
+#define LOGBOX_EOF   10        /* end of file retry delay (ms), as tail -f */
+
+static FILE *file = NULL;
+static GdkColor *old_fgcolor = NULL;   /* --keep-colors */
+static GdkColor *old_bgcolor = NULL;
+
+static void vt_to_gdk_color(gint color, GdkColor **fgcolor, GdkColor **bgcolor)
+{
+    static const GdkColor BLACK     = { 0, 0x0000, 0x0000, 0x0000 };
+    static const GdkColor RED       = { 0, 0xffff, 0x0000, 0x0000 };
+    static const GdkColor GREEN     = { 0, 0x0000, 0xffff, 0x0000 };
+    static const GdkColor BLUE      = { 0, 0x0000, 0x0000, 0xffff };
+    static const GdkColor MAGENTA   = { 0, 0xffff, 0x0000, 0xffff };
+    static const GdkColor YELLOW    = { 0, 0xffff, 0xffff, 0x0000 };
+    static const GdkColor CYAN      = { 0, 0x0000, 0xffff, 0xffff };
+    static const GdkColor WHITE     = { 0, 0xffff, 0xffff, 0xffff };
+    switch (color)
+    {
+        case 30: *fgcolor = (GdkColor *) &BLACK;  break;
+        case 31: *fgcolor = (GdkColor *) &RED;    break;
+        case 32: *fgcolor = (GdkColor *) &GREEN;  break;
+        case 33: *fgcolor = (GdkColor *) &YELLOW; break;
+        case 34: *fgcolor = (GdkColor *) &BLUE;   break;
+        case 35: *fgcolor = (GdkColor *) &MAGENTA; break;
+        case 36: *fgcolor = (GdkColor *) &CYAN;  break;
+        case 37: *fgcolor = (GdkColor *) &WHITE; break;
+        case 38: *fgcolor = NULL; break;
+        //--
+        case 40: *bgcolor = (GdkColor *) &BLACK; break;
+        case 41: *bgcolor = (GdkColor *) &RED;   break;
+        case 42: *bgcolor = (GdkColor *) &GREEN; break;
+        case 43: *bgcolor = (GdkColor *) &YELLOW; break;
+        case 44: *bgcolor = (GdkColor *) &BLUE;   break;
+        case 45: *bgcolor = (GdkColor *) &MAGENTA;break;
+        case 46: *bgcolor = (GdkColor *) &CYAN;  break;
+        case 47: *bgcolor = (GdkColor *) &WHITE; break;
+        case 48: *bgcolor = NULL; break;
+    }
+}
+
+/* Turns a line (without its linefeed) into a row, in place */
+static void logbox_parse(gchar *line, logbox_row *row)
+{
+    gchar *p;
+    gint color, len = strlen(line);
+    struct tm date;
+    time_t now;
+
+    if (Xdialog.keep_colors) {
+        row->fgcolor = old_fgcolor;
+        row->bgcolor = old_bgcolor;
+    } else {
+        row->fgcolor = row->bgcolor = NULL;
+    }
+    if ((p = strstr(line, "\033[1;")) != NULL) {
+        p += 4;
+        color = atoi(p);
+        vt_to_gdk_color(color, &row->fgcolor, &row->bgcolor);
+
+        while (++p < line + len) {
+            if (*p == ';') {
+                color = atoi(++p);
+                vt_to_gdk_color(color, &row->fgcolor, &row->bgcolor);
+                p += 2;
+            }
+            if (*p == 'm')
+                break;
+        }
+        if (Xdialog.keep_colors) {
+            old_fgcolor = row->fgcolor;
+            old_bgcolor = row->bgcolor;
+        }
+        remove_vt_sequences(line);
+    }
+    row->text = line;
+
+    row->stamp[0] = '\0';
+    if (Xdialog.time_stamp) {
+        time(&now);
+        localtime_r(&now, &date);
+        if (Xdialog.date_stamp) {
+            snprintf(row->stamp, sizeof(row->stamp), "%02d/%02d/%d %02d:%02d:%02d ",
+                     date.tm_mday, date.tm_mon+1, date.tm_year+1900,
+                     date.tm_hour, date.tm_min, date.tm_sec);
+        } else {
+            snprintf(row->stamp, sizeof(row->stamp), "%02d:%02d:%02d",
+                     date.tm_hour, date.tm_min, date.tm_sec);
+        }
+    }
+}
+
+#if GLIB_CHECK_VERSION(2,32,0)
+
+static GThread *reader = NULL;
+static gint stopping = FALSE;
+
+/* Ring of the rows, whose texts are owned by the ring until taken */
+static logbox_row ring[LOGBOX_RING];
+static gint head = 0;                  /* rows written, by the reader thread */
+static gint tail = 0;                  /* rows taken, by the GTK+ thread */
+static gchar *taken = NULL;            /* text of the last row taken */
+
+/* Waits for room in the ring, returning FALSE if the logbox is closed */
+static gboolean ring_push(logbox_row *row)
+{
+    guint h = (guint) head;
+
+    while (h - (guint) g_atomic_int_get(&tail) == LOGBOX_RING) {
+        if (g_atomic_int_get(&stopping))
+            return FALSE;
+        g_usleep(1000);
+    }
+    ring[h % LOGBOX_RING] = *row;
+    g_atomic_int_set(&head, (gint) (h + 1));
+    return TRUE;
+}
+
+static gpointer logbox_reader(gpointer data)
+{
+    static line_buffer buffer;
+    gchar line[MAX_LABEL_LENGTH], *space;
+    struct pollfd input;
+    logbox_row row;
+    gsize size, filled = 0, taken_bytes = 0, used;
+    gssize n;
+    gboolean loaded = FALSE;
+
+    input.fd = fileno(file);
+    input.events = POLLIN;
+    line_buffer_reset(&buffer);
+
+    while (!g_atomic_int_get(&stopping)) {
+        while (line_buffer_next(&buffer, line, sizeof(line))) {
+            /* bytes used up to this line, the skipped ones included */
+            used = filled - (buffer.end - buffer.start);
+            row.length = used - taken_bytes;
+            taken_bytes = used;
+            logbox_parse(line, &row);
+            row.text = g_strdup(row.text);
+            if (!ring_push(&row)) {
+                g_free(row.text);
+                return NULL;
+            }
+        }
+
+        if (poll(&input, 1, LOGBOX_POLL) <= 0)
+            continue;
+        space = line_buffer_space(&buffer, &size);
+        n = read(input.fd, space, size);
+        if (n > 0) {
+            line_buffer_fill(&buffer, n);
+            filled += n;
+        } else if (n == 0 && (!loaded || (input.revents & POLLHUP))) {
+            /* end of the initial contents or closed pipe: the last line
+             * may have no linefeed (and the rest of a truncated one is only
+             * counted, as a row without text) */
+            loaded = TRUE;
+            if (filled > taken_bytes) {
+                row.text = NULL;
+                if (line_buffer_flush(&buffer, line, sizeof(line))) {
+                    logbox_parse(line, &row);
+                    row.text = g_strdup(row.text);
+                }
+                row.length = filled - taken_bytes;
+                taken_bytes = filled;
+                if (!ring_push(&row)) {
+                    g_free(row.text);
+                    return NULL;
+                }
+            }
+            g_usleep(LOGBOX_EOF * 1000);
+        } else if (n == 0 || (errno != EINTR && errno != EAGAIN))
+            g_usleep(LOGBOX_EOF * 1000);    /* wait for more lines */
+    }
+    return NULL;
+}
+
+#endif
+
+/* Starts reading the logged file (see create_logbox()) */
+void logbox_start(FILE *logged)
+{
+    file = logged;
+    old_fgcolor = old_bgcolor = NULL;
+#if GLIB_CHECK_VERSION(2,32,0)
+    head = tail = 0;
+    stopping = FALSE;
+    reader = g_thread_new("logbox", logbox_reader, NULL);
+#endif
+}
+
+/* Takes the next row, if any: its text is valid until the next call */
+gboolean logbox_next(logbox_row *row)
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+    guint t = (guint) tail;
+
+    g_free(taken);
+    taken = NULL;
+    if (t == (guint) g_atomic_int_get(&head))
+        return FALSE;
+    *row = ring[t % LOGBOX_RING];
+    taken = row->text;
+    g_atomic_int_set(&tail, (gint) (t + 1));
+    return TRUE;
+#else
+    static gchar line[MAX_LABEL_LENGTH];
+    gint len;
+
+    if (fgets(line, MAX_LABEL_LENGTH, file) == NULL)
+        return FALSE;
+    row->length = len = strlen(line);
+    if ((len > 0) && (line[len - 1] == '\n')) {
+        line[--len] = 0;
+    }
+    logbox_parse(line, row);
+    return TRUE;
+#endif
+}
+
+/* Stops reading, before the file is closed (see destroy_event()) */
+void logbox_stop(void)
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+    if (reader != NULL) {
+        g_atomic_int_set(&stopping, TRUE);
+        g_thread_join(reader);
+        reader = NULL;
+        for (; tail != head; tail++)
+            g_free(ring[(guint) tail % LOGBOX_RING].text);
+        g_free(taken);
+        taken = NULL;
+    }
+#endif
+    file = NULL;
+}
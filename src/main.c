@@ -7,7 +7,9 @@
 #include <getopt.h>
 
 #include "interface.h"
+#include "callbacks.h"
 #include "support.h"
+#include "server.h"
 #include "time.h"
 
 /* A structure used to pass Xdialog parameters. */
@@ -16,6 +18,10 @@ Xdialog_data Xdialog;
 /* (c)dialog compatibility flag */
 gboolean dialog_compat = FALSE;
 
+/* Script mode (--script) settings: top level window reuse and results file */
+gboolean reuse_window = FALSE;
+FILE *script_output = NULL;
+
 /* Usage displaying */
 
 #define HELP_TEXT2 \
@@ -32,8 +38,10 @@ Common options:\n\
   --center | --right | --left | --fill\n\
   --no-wrap | --wrap\n\
   --cr-wrap | --no-cr-wrap\n\
-  --stderr | --stdout\n\
+  --stderr | --stdout | --output-fd <fd>\n\
   --separator <character> | --separate-output\n\
+  --output-format text|nul|json\n\
+  --control-fd <fd>\n\
   --buttons-style default|icon|text\n\
 \n\
 Transient options:\n\
@@ -45,10 +53,14 @@ Transient options:\n\
   --reverse\n\
   --keep-colors\n\
   --interval <timeout>\n\
+  --report-changes (reports the results as they change)\n\
+  --report-sequence (numbers the --report-changes reports)\n\
   --timeout <timeout> (in seconds)\n\
   --no-tags\n\
   --item-help (if used, the {...} parameters are needed in menus/lists widgets)\n\
   --default-item <tag>\n\
+  --items-from <file> (reads the list items from <file>, \"-\" for stdin)\n\
+  --filter (adds a filter entry to menus/lists widgets)\n\
   --icon <filename>\n\
   --no-ok\n\
   --no-cancel\n\
@@ -103,6 +115,8 @@ Special options:\n\
   --version        (prints version number to stderr and exits).\n\
   --print-version    (same as above in a cdialog-compatible way).\n\
   --print-maxsize    (prints maximum menu size in characters and exits).\n\
+  --server <socket>  (runs as a dialog server, see Xdialog-client).\n\
+  --script <file>    (runs the sequence of dialogs described in <file>).\n\
 \n\
 Note that <height> and <width> are in characters and may be replaced by a single\n\
 XSIZExYSIZE[+/-XORG+/-YORG] parameter (like the one passed in the -geometry option\n\
@@ -114,7 +128,7 @@ will maximize it.\n\
     as the print command. If <printer> is \"\" (an empty string), the "PRINTER_CMD_OPTION"\n\
     option is not used.\n\n"
 
-#define HELP_MSG_SIZE 4200
+#define HELP_MSG_SIZE 6000
 
 /* List of all recognized Xdialog options */
 enum {
@@ -167,12 +181,15 @@ enum {
     C_NOCRWRAP,
     C_STDOUT,
     C_STDERR,
+    C_OUTPUTFD,
     C_NOCLOSE,
     C_ALLOWCLOSE,
     C_BUTTONSSTYLE,
     C_RCFILE,
     C_SEPARATOR,
     C_SEPARATEOUTPUT,
+    C_OUTPUTFORMAT,
+    C_CONTROLFD,
     /* Transient options */
     T_FIXEDFONT,
     T_PASSWORD,
@@ -188,6 +205,8 @@ enum {
     T_NOTAGS,
     T_ITEMHELP,
     T_DEFAULTITEM,
+    T_ITEMSFROM,
+    T_FILTER,
     T_HELP,
     T_PRINT,
     T_WIZARD,
@@ -197,6 +216,8 @@ enum {
     T_EXTRALABEL,
     T_ICON,
     T_INTERVAL,
+    T_REPORTCHANGES,
+    T_REPORTSEQUENCE,
     T_TIMEOUT,
     T_CHECK,
     T_BEEP,
@@ -259,7 +280,7 @@ static void print_help_info(char *name, char *errmsg)
     gtk_widget_show_all (Xdialog.window);
     gtk_main();
 
-    exit(255);
+    xdialog_exit(255);
 }
 
 /* Returns TRUE when var_name environment variable exists and is set to "true"
@@ -446,6 +467,48 @@ static int get_list_size (int argc, char *argv[], int *optind, int parameters,
 }
 
 
+/* Names of the list items fields, for the --items-from JSON objects */
+static const gchar * const combo_fields[] = { "item" };
+static const gchar * const menu_fields[]  = { "tag", "item", "help" };
+static const gchar * const list_fields[]  = { "tag", "item", "status", "help" };
+static const gchar * const tree_fields[]  = { "tag", "item", "status", "depth", "help" };
+
+/* Returns the parameters of the list items, taken from the command line (in
+ * which case optind is moved past them) or read from the --items-from file.
+ */
+static char **get_list_items(int argc, char *argv[], int *optind, int parameters,
+                             gboolean with_list_height, const gchar * const *names,
+                             int *list_size)
+{
+    char **items;
+
+    if (Xdialog.items_from == NULL) {
+        *list_size = get_list_size(argc, argv, optind, parameters,
+                                   with_list_height);
+        items = argv + *optind;
+        *optind += parameters * (*list_size);
+        return items;
+    }
+
+    if (with_list_height) {
+        if (*optind >= argc)
+            print_help_info(argv[0], "missing list parameters");
+        Xdialog.list_height = atoi(argv[(*optind)++]);
+        if (Xdialog.list_height < 0)
+            print_help_info(argv[0], "negative list height");
+    }
+    /* The items are kept when the box is shown again after --help */
+    if (Xdialog.items == NULL &&
+        read_items(Xdialog.items_from, parameters, names) < 0)
+        xdialog_exit(255);
+
+    *list_size = Xdialog.items->len / parameters;
+    if (*list_size < 1)
+        print_help_info(argv[0], "missing list parameters");
+    return (char **) Xdialog.items->pdata;
+}
+
+
 static int param_number(int argc, char *argv[], int *optind)
 {
     int next_opt, i;
@@ -466,13 +529,16 @@ static int param_number(int argc, char *argv[], int *optind)
  */
 #define GETOPT_BUG 1
 
-/* Main routine */
+/* Box options processing: parses an Xdialog command line and runs the box(es)
+ * it holds, returning the exit code.  This is called once per request when
+ * Xdialog runs as a dialog server, so that all the settings are reset here.
+ */
 
-int main(int argc, char *argv[])
+static int xdialog_main(int argc, char *argv[])
 {
     gchar title_tmp[MAX_TITLE_LENGTH];
     gchar backt_tmp[MAX_BACKTITLE_LENGTH];
-    gchar help_text[MAX_LABEL_LENGTH];
+    gchar *help_text = "";
     int option_index = 0, old_optind = 0;
 #if GETOPT_BUG
     int old_option_index = 0;
@@ -482,6 +548,7 @@ int main(int argc, char *argv[])
     gboolean win = FALSE;
     gint timeout, percent, x, y;
     gint list_size = 0;
+    char **items;
     gint min = 0, max = 0, deflt =0;
     gint day = 0, month = 0, year = 0;
     gint hours = 0, minutes = 0, seconds = 0;
@@ -542,6 +609,7 @@ int main(int argc, char *argv[])
         { "cr-wrap",        0, 0, C_CRWRAP     },
         { "no-cr-wrap",     0, 0, C_NOCRWRAP   },
         { "stdout",         0, 0, C_STDOUT     },
+        { "output-fd",      1, 0, C_OUTPUTFD   },
         { "stderr",         0, 0, C_STDERR     },
         { "no-close",       0, 0, C_NOCLOSE    },
         { "allow-close",    0, 0, C_ALLOWCLOSE },
@@ -549,6 +617,8 @@ int main(int argc, char *argv[])
         { "rc-file",        1, 0, C_RCFILE     },
         { "separator",      1, 0, C_SEPARATOR  },
         { "separate-output",0, 0, C_SEPARATEOUTPUT },
+        { "output-format",  1, 0, C_OUTPUTFORMAT },
+        { "control-fd",     1, 0, C_CONTROLFD  },
         /* Transient options */
         { "fixed-font",     0, 0, T_FIXEDFONT  },
         { "password",       2, 0, T_PASSWORD   },
@@ -563,6 +633,8 @@ int main(int argc, char *argv[])
         { "no-tags",        0, 0, T_NOTAGS     },
         { "item-help",      0, 0, T_ITEMHELP   },
         { "default-item",   1, 0, T_DEFAULTITEM },
+        { "items-from",     1, 0, T_ITEMSFROM  },
+        { "filter",         0, 0, T_FILTER     },
         { "help",           1, 0, T_HELP       },
         { "print",          1, 0, T_PRINT      },
         { "wizard",         0, 0, T_WIZARD     },
@@ -572,6 +644,8 @@ int main(int argc, char *argv[])
         { "cancel-label",   1, 0, T_CANCELLABEL },
         { "icon",           1, 0, T_ICON       },
         { "interval",       1, 0, T_INTERVAL   },
+        { "report-changes", 0, 0, T_REPORTCHANGES },
+        { "report-sequence", 0, 0, T_REPORTSEQUENCE },
         { "timeout",        1, 0, T_TIMEOUT    },
         { "check",          1, 0, T_CHECK      },
         { "beep",           0, 0, T_BEEP       },
@@ -594,6 +668,7 @@ int main(int argc, char *argv[])
     /* Check if the dialog high compatibility mode is requested */
     dialog_compat = is_true(HIGH_DIALOG_COMPAT);
 
+    free_items();    /* left over by a previous run in server or script mode */
     memset(&Xdialog, 0, sizeof(Xdialog_data));    /* Set all parameters to zero/NULL */
 
 #if FALSE != 0    /* Just in case your compiler uses a different value for FALSE... */
@@ -616,6 +691,7 @@ int main(int argc, char *argv[])
     Xdialog.cr_wrap     = FALSE;        /* Don't wrap at linefeeds by default */
     Xdialog.ignore_eof  = FALSE;        /* Don't ignore EOF in infobox/gauge */
     Xdialog.smooth      = FALSE;        /* logbox - ignored  */
+    Xdialog.filter      = FALSE;        /* No filter entry in menus/lists */
 #endif
     if (dialog_compat) {
         Xdialog.justify = GTK_JUSTIFY_LEFT;    /* Left justify messages as default */
@@ -634,6 +710,8 @@ int main(int argc, char *argv[])
 #if 0    /* Not needed because of the memset: listed here as a reminder only... */
     Xdialog.passwd          = 0;            /* Don't use passwd input as default */
     Xdialog.interval        = 0;            /* Don't report periodically as default */
+    Xdialog.report_changes  = FALSE;        /* Don't report the changes as default */
+    Xdialog.report_sequence = FALSE;        /* Don't number the reports */
     Xdialog.timeout         = 0;            /* Don't use a timeout */
     Xdialog.tips            = 0;            /* Don't use tips for items in lists */
     Xdialog.beep            = 0;            /* Don't beep */
@@ -646,26 +724,11 @@ int main(int argc, char *argv[])
     strcpy(Xdialog.title, XDIALOG);         /* Default widget title */
     strcpy(Xdialog.separator, "/");         /* Default results separator */
 
-    /* Set custom log handler routines, so that GTK, GDK and GLIB never
-         * print anything on stdout, but always use stderr instead.
-     */
-    g_log_set_handler("Gdk", G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL
-                      | G_LOG_FLAG_RECURSION, g_log_xdialog_handler, NULL);
-    g_log_set_handler("GLib", G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL
-                      | G_LOG_FLAG_RECURSION, g_log_xdialog_handler, NULL);
-    g_log_set_handler("Gtk", G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL
-                      | G_LOG_FLAG_RECURSION, g_log_xdialog_handler, NULL);
-    g_log_set_handler(NULL, G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL
-                      | G_LOG_FLAG_RECURSION, g_log_xdialog_handler, NULL);
-
-    if (!gtk_init_check(&argc, &argv)) {
-        fprintf(stderr,
-                "%s: Error initializing the GUI...\n"
-                "Do you run under X11 with GTK+ v1.2.0+ installed ?\n", argv[0]);
-        return 255;
-    }
 
+    /* (Re)initialize getopt, as we may be called more than once */
     opterr = 0;
+    optind = 0;
+    trace_begin("options");
 
     while (TRUE)
     {
@@ -688,6 +751,14 @@ int main(int argc, char *argv[])
 show_again:
         win = FALSE;
 
+        if (optcode <= B_TIMEBOX) {    /* a box option */
+            if (Xdialog.exit_code != 2)    /* not re-shown after help */
+                trace_end("options");
+            trace_begin(long_options[option_index].name);
+            if (script_output != NULL)    /* results are captured */
+                Xdialog.output = script_output;
+        }
+
         switch (optcode) {
         /* Box options */
             case B_YESNO:        /* a yesno box */
@@ -783,9 +854,9 @@ show_again:
                 break;
             case B_COMBOBOX:    /* a combo box */
                 get_box_size(argc, argv, &optind);
-                list_size = get_list_size(argc, argv, &optind, 1, FALSE);
-                create_combobox(optarg, argv+optind, list_size);
-                optind += list_size;
+                items = get_list_items(argc, argv, &optind, 1, FALSE,
+                                       combo_fields, &list_size);
+                create_combobox(optarg, items, list_size);
                 win = TRUE;
                 break;
             case B_RANGEBOX:    /* a range box */
@@ -846,36 +917,33 @@ show_again:
                 break;
             case B_MENUBOX:        /* a menu box */
                 get_box_size(argc, argv, &optind);
-                list_size = get_list_size(argc, argv, &optind,
-                                          2 + Xdialog.tips, TRUE);
-                create_menubox(optarg, argv+optind, list_size);
-                optind += (2+Xdialog.tips)*list_size;
+                items = get_list_items(argc, argv, &optind, 2 + Xdialog.tips,
+                                       TRUE, menu_fields, &list_size);
+                create_menubox(optarg, items, list_size);
                 win = TRUE;
                 break;
             case B_CHECKLIST:    /* a check list */
             case B_RADIOLIST:    /* a radio list */
                 get_box_size(argc, argv, &optind);
-                list_size = get_list_size(argc, argv, &optind, 3+Xdialog.tips, TRUE);
+                items = get_list_items(argc, argv, &optind, 3 + Xdialog.tips,
+                                       TRUE, list_fields, &list_size);
                 create_itemlist(optarg,
                         optcode == B_CHECKLIST ? CHECKLIST : RADIOLIST,
-                        argv+optind, list_size);
-                optind += (3+Xdialog.tips)*list_size;
+                        items, list_size);
                 win = TRUE;
                 break;
             case B_BUILDLIST:    /* a build list */
                 get_box_size(argc, argv, &optind);
-                list_size = get_list_size(argc, argv, &optind,
-                                          3+Xdialog.tips, TRUE);
-                create_buildlist(optarg, argv+optind, list_size);
-                optind += (3+Xdialog.tips)*list_size;
+                items = get_list_items(argc, argv, &optind, 3 + Xdialog.tips,
+                                       TRUE, list_fields, &list_size);
+                create_buildlist(optarg, items, list_size);
                 win = TRUE;
                 break;
             case B_TREEVIEW:    /* a tree view */
                 get_box_size(argc, argv, &optind);
-                list_size = get_list_size(argc, argv, &optind,
-                                          4 + Xdialog.tips, TRUE);
-                create_treeview(optarg, argv+optind, list_size);
-                optind += (4+Xdialog.tips)*list_size;
+                items = get_list_items(argc, argv, &optind, 4 + Xdialog.tips,
+                                       TRUE, tree_fields, &list_size);
+                create_treeview(optarg, items, list_size);
                 win = TRUE;
                 break;
             case B_FSELECT:        /* file selector */
@@ -1009,6 +1077,9 @@ show_again:
             case C_STDERR:        /* --stderr option */
                 Xdialog.output = stderr;
                 break;
+            case C_OUTPUTFD:    /* --output-fd option */
+                Xdialog.output = result_stream(optarg);
+                break;
             case C_NOCLOSE:        /* --no-close option */
                 Xdialog.no_close = TRUE;
                 break;
@@ -1026,6 +1097,12 @@ show_again:
                     print_help_info(argv[0], "bad button style name");
                 break;
             case C_RCFILE:        /* --rc-file option */
+                /* the rc styles of a dialog would stay for the next ones */
+                if (server_serving()) {
+                    fprintf(stderr, XDIALOG": --rc-file is not supported by "
+                            "the dialog server\n");
+                    xdialog_exit(255);
+                }
                 strncpy(Xdialog.rc_file, optarg,
                        sizeof(Xdialog.wmclass));
                 break;
@@ -1038,6 +1115,19 @@ show_again:
             case C_SEPARATEOUTPUT:    /* --separate-output option */
                 Xdialog.separator[0] = '\n';
                 break;
+            case C_OUTPUTFORMAT:    /* --output-format option */
+                if (!strcmp(optarg, "text"))
+                    Xdialog.output_format = OUTPUT_TEXT;
+                else if (!strcmp(optarg, "nul"))
+                    Xdialog.output_format = OUTPUT_NUL;
+                else if (!strcmp(optarg, "json"))
+                    Xdialog.output_format = OUTPUT_JSON;
+                else
+                    print_help_info(argv[0], "bad output format name");
+                break;
+            case C_CONTROLFD:    /* --control-fd option */
+                control_open(optarg);
+                break;
         /* Transient options */
             case T_FIXEDFONT:    /* --fixed-font option */
                 Xdialog.fixed_font = TRUE;
@@ -1084,8 +1174,14 @@ show_again:
             case T_DEFAULTITEM:    /* --default-item option */
                 strncpy(Xdialog.default_item, optarg, sizeof(Xdialog.default_item));
                 break;
+            case T_ITEMSFROM:    /* --items-from option */
+                Xdialog.items_from = optarg;
+                break;
+            case T_FILTER:    /* --filter option */
+                Xdialog.filter = TRUE;
+                break;
             case T_HELP:        /* --help option */
-                strncpy(help_text, optarg, sizeof(help_text));
+                help_text = optarg;
                 Xdialog.help = TRUE;
                 break;
             case T_PRINT:        /* --print option */
@@ -1121,6 +1217,12 @@ show_again:
                 if (Xdialog.interval < 0)
                     print_help_info(argv[0], "bad interval value");
                 break;
+            case T_REPORTSEQUENCE:    /* --report-sequence option */
+                Xdialog.report_sequence = TRUE;
+                /* fall through */
+            case T_REPORTCHANGES:    /* --report-changes option */
+                Xdialog.report_changes = TRUE;
+                break;
             case T_TIMEOUT:        /* --timeout option */
                 Xdialog.timeout = -1;
                 if (optarg != NULL)
@@ -1174,7 +1276,12 @@ show_again:
                 continue;    /* don't try to open a window, skip to next option */
         }
         if (win) {
+            trace_end(long_options[option_index].name);
+            drop_spare_window();
+            trace_window(Xdialog.window);
             gtk_widget_show_all (Xdialog.window);
+            control_start();
+            watchdog_start();
             gtk_main();
 
             switch (Xdialog.exit_code) {
@@ -1223,6 +1330,8 @@ show_again:
             Xdialog.reverse       = FALSE;
             Xdialog.keep_colors   = FALSE;
             Xdialog.interval      = 0;
+            Xdialog.report_changes  = FALSE;
+            Xdialog.report_sequence = FALSE;
             Xdialog.timeout       = 0;
             Xdialog.icon          = FALSE;
             Xdialog.buttons       = TRUE;
@@ -1240,11 +1349,16 @@ show_again:
             Xdialog.beep          = 0;
             Xdialog.set_origin    = FALSE;
             Xdialog.default_item[0] = 0;
+            Xdialog.items_from      = NULL;
+            Xdialog.filter          = FALSE;
+            free_items();
             Xdialog.ok_label[0]     = 0;
             Xdialog.cancel_label[0] = 0;
             Xdialog.extra_label[0]  = 0;
             Xdialog.ignore_eof      = FALSE;
             Xdialog.smooth          = FALSE;
+
+            trace_begin("options");
         }
     }
 
@@ -1252,3 +1366,45 @@ show_again:
         print_help_info(argv[0], "missing box option");
     return 0;
 }
+
+/* Main routine */
+
+int main(int argc, char *argv[])
+{
+    /* Startup phases tracing, if requested */
+    trace_init();
+    watchdog_init();
+
+    /* Set custom log handler routines, so that GTK, GDK and GLIB never
+         * print anything on stdout, but always use stderr instead.
+     */
+    g_log_set_handler("Gdk", G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL
+                      | G_LOG_FLAG_RECURSION, g_log_xdialog_handler, NULL);
+    g_log_set_handler("GLib", G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL
+                      | G_LOG_FLAG_RECURSION, g_log_xdialog_handler, NULL);
+    g_log_set_handler("Gtk", G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL
+                      | G_LOG_FLAG_RECURSION, g_log_xdialog_handler, NULL);
+    g_log_set_handler(NULL, G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL
+                      | G_LOG_FLAG_RECURSION, g_log_xdialog_handler, NULL);
+
+    trace_begin("gtk_init_check");
+    if (!gtk_init_check(&argc, &argv)) {
+        fprintf(stderr,
+                "%s: Error initializing the GUI...\n"
+                "Do you run under X11 with GTK+ v1.2.0+ installed ?\n", argv[0]);
+        return 255;
+    }
+    trace_end("gtk_init_check");
+
+    /* Dialog server and script modes (must be the only option) */
+    if (argc == 3 && (strcmp(argv[1], "--server") == 0 ||
+                      strcmp(argv[1], "-server") == 0))
+        return xdialog_server(argv[2], xdialog_main);
+    if (argc == 3 && (strcmp(argv[1], "--script") == 0 ||
+                      strcmp(argv[1], "-script") == 0)) {
+        reuse_window = TRUE;
+        return xdialog_script(argv[2], xdialog_main);
+    }
+
+    return xdialog_main(argc, argv);
+}
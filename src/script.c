@@ -0,0 +1,269 @@
+/*
+ * Script mode for Xdialog (--script <file>).
+ *
+ * The script holds one dialog per line, written as Xdialog options (quoted
+ * as in a shell), and the dialogs are run one after the other within the
+ * same process and top level window.  Empty lines and lines starting with
+ * '#' are ignored, and a line ending with a backslash goes on with the next
+ * one.  Besides dialogs, a line may hold:
+ *
+ *   NAME=value       to set the NAME variable,
+ *   echo text...     to print text on stdout.
+ *
+ * $NAME and ${NAME} are replaced with the value of the NAME variable (or
+ * environment variable), $? with the exit code of the last dialog, $RESULT
+ * with its results (what Xdialog would have printed, without the trailing
+ * linefeed) and $$ with a single '$'.  The script stops at the first dialog
+ * returning a non-zero exit code (or failing on an error), unless its line
+ * starts with a "-" word.  The exit code of Xdialog is the one of the last
+ * dialog.
+ */
+
+#include "common.h"
+
+#include <ctype.h>
+#include <errno.h>
+
+#include "interface.h"
+#include "callbacks.h"
+#include "support.h"
+
+/* Global structures and variables */
+extern Xdialog_data Xdialog;
+extern FILE *script_output;
+
+static GHashTable *variables = NULL;
+
+static void set_variable(const gchar *name, const gchar *value)
+{
+    g_hash_table_replace(variables, g_strdup(name), g_strdup(value));
+}
+
+static const gchar *get_variable(const gchar *name)
+{
+    const gchar *value = g_hash_table_lookup(variables, name);
+
+    return value != NULL ? value : getenv(name);
+}
+
+static gboolean is_name_char(gchar c, gboolean first)
+{
+    return isalpha((guchar) c) || c == '_' || (!first && isdigit((guchar) c));
+}
+
+static gboolean is_assignment(const gchar *word)
+{
+    const gchar *p = word;
+
+    if (!is_name_char(*p, TRUE))
+        return FALSE;
+    while (is_name_char(*p, FALSE))
+        p++;
+    return *p == '=';
+}
+
+/* $NAME, ${NAME}, $? and $$ substitution */
+static gchar *substitute(const gchar *text)
+{
+    GString *result = g_string_sized_new(strlen(text));
+    const gchar *p = text, *end, *value;
+    gchar *name;
+
+    while (*p != '\0') {
+        if (*p != '$') {
+            g_string_append_c(result, *p++);
+            continue;
+        }
+        p++;
+        if (*p == '$') {
+            g_string_append_c(result, '$');
+            p++;
+            continue;
+        } else if (*p == '?') {
+            name = g_strdup("?");
+            p++;
+        } else if (*p == '{' && (end = strchr(p, '}')) != NULL) {
+            name = g_strndup(p + 1, end - p - 1);
+            p = end + 1;
+        } else if (is_name_char(*p, TRUE)) {
+            for (end = p; is_name_char(*end, FALSE); end++);
+            name = g_strndup(p, end - p);
+            p = end;
+        } else {
+            g_string_append_c(result, '$');
+            continue;
+        }
+        if ((value = get_variable(name)) != NULL)
+            g_string_append(result, value);
+        g_free(name);
+    }
+
+    return g_string_free(result, FALSE);
+}
+
+/* Reads back (and forgets) what the last dialog printed */
+static gchar *read_results(void)
+{
+    gchar *results;
+    long size;
+
+    fflush(script_output);
+    size = ftell(script_output);
+    if (size < 0)
+        size = 0;
+    results = g_malloc(size + 1);
+    rewind(script_output);
+    size = fread(results, 1, size, script_output);
+    results[size] = '\0';
+    if (size > 0 && results[size-1] == '\n')
+        results[size-1] = '\0';
+
+    rewind(script_output);
+    if (ftruncate(fileno(script_output), 0) != 0)
+        fprintf(stderr, XDIALOG": can't reset the results file: %s\n",
+                strerror(errno));
+
+    return results;
+}
+
+/* Runs a dialog line, returning its exit code */
+static int run_dialog(int (*run)(int argc, char *argv[]), int argc, char **words)
+{
+    jmp_buf env;
+    char **argv;
+    gchar *results, *code;
+    int status, i, n = 0;
+
+    argv = g_new(char *, argc + 2);
+    argv[n++] = XDIALOG;
+    for (i = 0; i < argc; i++)
+        argv[n++] = words[i];
+    argv[n] = NULL;
+
+    /* Errors abort the dialog instead of exiting (see xdialog_exit()) */
+    xdialog_set_exit_env(&env);
+    if ((status = setjmp(env)) == 0) {
+        status = run(n, argv);
+    } else {
+        status &= 0xff;
+        if (Xdialog.window != NULL)
+            gtk_widget_destroy(Xdialog.window);
+    }
+    xdialog_set_exit_env(NULL);
+    g_free(argv);
+    control_close();    /* no commands left over for the next line */
+
+    results = read_results();
+    set_variable("RESULT", results);
+    g_free(results);
+    code = g_strdup_printf("%d", status);
+    set_variable("?", code);
+    g_free(code);
+
+    return status;
+}
+
+int xdialog_script(const char *path, int (*run)(int argc, char *argv[]))
+{
+    GError *error = NULL;
+    GString *line;
+    gchar *contents, **lines, *text, *word, *value;
+    gchar **words;
+    gsize length;
+    gint argc, i, j;
+    gboolean assignment, ignore;
+    int status, code = 0;
+
+    if (!g_file_get_contents(path, &contents, &length, &error)) {
+        fprintf(stderr, XDIALOG": %s\n", error->message);
+        g_error_free(error);
+        return 255;
+    }
+    if ((script_output = tmpfile()) == NULL) {
+        fprintf(stderr, XDIALOG": can't create the results file: %s\n",
+                strerror(errno));
+        g_free(contents);
+        return 255;
+    }
+
+    variables = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    set_variable("?", "0");
+    set_variable("RESULT", "");
+
+    lines = g_strsplit(contents, "\n", -1);
+    g_free(contents);
+    line = g_string_new(NULL);
+
+    for (i = 0; lines[i] != NULL; i++) {
+        length = strlen(lines[i]);
+        if (length > 0 && lines[i][length-1] == '\r')
+            length--;
+        if (length > 0 && lines[i][length-1] == '\\') {
+            g_string_append_len(line, lines[i], length - 1);
+            continue;
+        }
+        g_string_append_len(line, lines[i], length);
+
+        text = g_strstrip(line->str);
+        if (*text == '\0' || *text == '#') {
+            g_string_truncate(line, 0);
+            continue;
+        }
+        if (!g_shell_parse_argv(text, &argc, &words, &error)) {
+            fprintf(stderr, XDIALOG": %s, line %d: %s\n",
+                    path, i + 1, error->message);
+            g_error_free(error);
+            code = 255;
+            break;
+        }
+        g_string_truncate(line, 0);
+        ignore = FALSE;
+        status = 0;
+
+        assignment = (argc == 1 && is_assignment(words[0]));
+        for (j = 0; j < argc; j++) {
+            word = substitute(words[j]);
+            g_free(words[j]);
+            words[j] = word;
+        }
+
+        if (assignment) {
+            value = strchr(words[0], '=');
+            *value++ = '\0';
+            set_variable(words[0], value);
+        } else if (strcmp(words[0], "echo") == 0) {
+            for (j = 1; j < argc; j++)
+                fprintf(stdout, j > 1 ? " %s" : "%s", words[j]);
+            fprintf(stdout, "\n");
+            fflush(stdout);
+        } else {
+            ignore = (strcmp(words[0], "-") == 0);
+            if (argc == 1 && ignore) {
+                fprintf(stderr, XDIALOG": %s, line %d: no dialog after -\n",
+                        path, i + 1);
+                ignore = FALSE;
+                status = 255;
+            } else
+                status = run_dialog(run, argc - ignore, words + ignore);
+            code = status;
+        }
+        g_strfreev(words);
+
+        if (status != 0 && !ignore)
+            break;
+    }
+
+    /* The last window is no more needed */
+    drop_spare_window();
+    while (gtk_events_pending())
+        gtk_main_iteration();
+
+    g_string_free(line, TRUE);
+    g_strfreev(lines);
+    g_hash_table_destroy(variables);
+    variables = NULL;
+    fclose(script_output);
+    script_output = NULL;
+
+    return code;
+}
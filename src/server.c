@@ -0,0 +1,400 @@
+/*
+ * Dialog server mode for Xdialog.
+ *
+ * GTK+ is initialized once, then dialog requests (an Xdialog command line
+ * plus the stdin, stdout and stderr of the client) are received on a UNIX
+ * socket and run one after the other, sparing the GTK+ initialization, X
+ * connection, rc file parsing and fonts setup to each dialog.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE    /* struct ucred */
+#endif
+
+#include "common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <locale.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#ifdef HAVE_STDIO_EXT_H
+#include <stdio_ext.h>
+#endif
+
+#include "interface.h"
+#include "support.h"
+#include "server.h"
+
+/* Global structures and variables */
+extern Xdialog_data Xdialog;
+
+#define SERVER_NFDS (3 + SERVER_MAX_FDS)
+
+/* Descriptors passed for the options of the request being run (see
+ * server_fd()): client numbers and server side descriptors.
+ */
+static gboolean serving = FALSE;
+static unsigned int option_nfds = 0;
+static int option_fds[SERVER_MAX_FDS];
+static int option_client_fds[SERVER_MAX_FDS];
+
+/* SERVER_ENV variables of the server, while a request is run */
+static const char *env_names[] = SERVER_ENV;
+static char *saved_env[G_N_ELEMENTS(env_names)];
+
+int server_serving(void)
+{
+    return serving;
+}
+
+int server_fd(int fd)
+{
+    unsigned int i;
+
+    if (!serving || fd <= 2)
+        return fd;
+    for (i = 0; i < option_nfds; i++) {
+        if (option_client_fds[i] == fd)
+            return option_fds[i];
+    }
+    return -1;
+}
+
+static int server_listen(const char *path)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    mode_t mask;
+    int fd, bound;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, XDIALOG": socket path too long: %s\n", path);
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, XDIALOG": can't listen on %s: %s\n",
+                path, strerror(errno));
+        return -1;
+    }
+
+    /* Remove the socket left behind by a dead server, if any, but not the
+     * one of a running server
+     */
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+            fprintf(stderr, XDIALOG": a server is already running on %s\n", path);
+            close(fd);
+            return -1;
+        }
+        if (errno == ECONNREFUSED)
+            unlink(path);
+        close(fd);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    }
+
+    /* Only the user may connect to the socket (see server_peer_allowed()) */
+    mask = umask(0077);
+    bound = fd >= 0 && bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0;
+    umask(mask);
+    if (!bound || chmod(path, 0600) != 0 || listen(fd, 16) != 0) {
+        fprintf(stderr, XDIALOG": can't listen on %s: %s\n",
+                path, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    return fd;
+}
+
+/* Whether the client runs as the same user as the server */
+static gboolean server_peer_allowed(int fd)
+{
+#if defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__) || \
+    defined(__DragonFly__) || defined(__APPLE__)
+    uid_t uid;
+    gid_t gid;
+
+    return getpeereid(fd, &uid, &gid) == 0 && uid == geteuid();
+#elif defined(SO_PEERCRED)
+    struct ucred cred;
+    socklen_t length = sizeof(cred);
+
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &length) == 0 &&
+           cred.uid == geteuid();
+#else
+    return TRUE;    /* the socket mode is all there is */
+#endif
+}
+
+static gboolean read_all(int fd, void *buffer, size_t length)
+{
+    char *p = buffer;
+    ssize_t n;
+
+    while (length > 0) {
+        n = read(fd, p, length);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FALSE;
+        p += n;
+        length -= n;
+    }
+    return TRUE;
+}
+
+/* Receives a request: returns its (g_free'able) argv array, NULL terminated
+ * and followed by its environment (as "NAME=value" strings, NULL terminated
+ * too), whose strings are held in *payload, the client working directory
+ * being the first string of *payload.  Returns NULL on error.
+ */
+static char **server_receive(int fd, int *argc, char **payload,
+                             int fds[SERVER_NFDS], unsigned int *nfds)
+{
+    server_request request;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union {
+        struct cmsghdr align;
+        char buffer[CMSG_SPACE(SERVER_NFDS * sizeof(int))];
+    } control;
+    char *p, *end, **argv = NULL;
+    unsigned int i, received = 0;
+    ssize_t n;
+
+    for (i = 0; i < SERVER_NFDS; i++)
+        fds[i] = -1;
+    *payload = NULL;
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &request;
+    iov.iov_len = sizeof(request);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+
+    do
+        n = recvmsg(fd, &msg, 0);
+    while (n < 0 && errno == EINTR);
+    if (n <= 0)
+        return NULL;
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+            received == 0 && cmsg->cmsg_len >= CMSG_LEN(3 * sizeof(int)) &&
+            cmsg->cmsg_len <= CMSG_LEN(SERVER_NFDS * sizeof(int))) {
+            received = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            memcpy(fds, CMSG_DATA(cmsg), received * sizeof(int));
+        }
+    }
+
+    if ((size_t) n < sizeof(request) &&
+        !read_all(fd, (char *) &request + n, sizeof(request) - n))
+        goto error;
+    if (memcmp(request.magic, SERVER_MAGIC, 4) != 0 || received < 3 ||
+        request.nfds > SERVER_MAX_FDS || received != 3 + request.nfds ||
+        request.argc == 0 || request.nenv >= G_N_ELEMENTS(env_names) ||
+        request.length > SERVER_MAX_REQUEST)
+        goto error;
+    for (i = 0; i < request.nfds; i++) {
+        fcntl(fds[3 + i], F_SETFD, FD_CLOEXEC);
+        option_client_fds[i] = request.fds[i];
+    }
+    *nfds = request.nfds;
+
+    *payload = g_malloc(request.length + 1);
+    if (!read_all(fd, *payload, request.length))
+        goto error;
+    (*payload)[request.length] = '\0';
+
+    argv = g_new(char *, request.argc + 1 + request.nenv + 1);
+    p = *payload;
+    end = *payload + request.length;
+    p += strlen(p) + 1;    /* skip the working directory */
+    for (i = 0; i < request.argc + 1 + request.nenv; i++) {
+        if (i == request.argc) {
+            argv[i] = NULL;
+            continue;
+        }
+        if (p >= end)
+            goto error;
+        argv[i] = p;
+        p += strlen(p) + 1;
+    }
+    argv[i] = NULL;
+    *argc = request.argc;
+
+    return argv;
+
+error:
+    for (i = 0; i < SERVER_NFDS; i++) {
+        if (fds[i] >= 0)
+            close(fds[i]);
+    }
+    g_free(argv);
+    g_free(*payload);
+    *payload = NULL;
+    return NULL;
+}
+
+/* Sets the client environment "env" in place of ours (the SERVER_ENV
+ * variables only), or restores ours (NULL "env").
+ */
+static void server_setenv(char *env[])
+{
+    unsigned int i, j;
+    size_t len;
+
+    for (i = 0; env_names[i] != NULL; i++) {
+        if (env != NULL) {
+            saved_env[i] = g_strdup(getenv(env_names[i]));
+            unsetenv(env_names[i]);
+            len = strlen(env_names[i]);
+            for (j = 0; env[j] != NULL; j++) {
+                if (strncmp(env[j], env_names[i], len) == 0 && env[j][len] == '=')
+                    setenv(env_names[i], env[j] + len + 1, TRUE);
+            }
+        } else {
+            if (saved_env[i] != NULL)
+                setenv(env_names[i], saved_env[i], TRUE);
+            else
+                unsetenv(env_names[i]);
+            g_free(saved_env[i]);
+            saved_env[i] = NULL;
+        }
+    }
+    setlocale(LC_ALL, "");
+}
+
+/* Runs one request with the client standard descriptors in place of ours */
+static int server_run(int (*run)(int argc, char *argv[]), int argc,
+                      char *argv[], const char *cwd, int fds[SERVER_NFDS],
+                      unsigned int nfds)
+{
+    jmp_buf env;
+    unsigned int i;
+    int status;
+
+    fflush(stdout);
+    fflush(stderr);
+    for (i = 0; i < 3; i++) {
+        dup2(fds[i], i);
+        close(fds[i]);
+    }
+    /* The option descriptors are only used through server_fd() */
+    for (i = 0; i < nfds; i++)
+        option_fds[i] = fds[3 + i];
+    option_nfds = nfds;
+    serving = TRUE;
+    /* Don't let the previous client input leak into this dialog */
+    clearerr(stdin);
+#ifdef HAVE_STDIO_EXT_H
+    __fpurge(stdin);
+#endif
+    my_scanf_reset();
+
+    if (*cwd != '\0' && chdir(cwd) != 0)
+        fprintf(stderr, XDIALOG": can't change directory to %s: %s\n",
+                cwd, strerror(errno));
+    server_setenv(argv + argc + 1);
+
+    /* Errors abort the request instead of exiting (see xdialog_exit()) */
+    xdialog_set_exit_env(&env);
+    if ((status = setjmp(env)) == 0) {
+        status = run(argc, argv);
+    } else {
+        status &= 0xff;
+        if (Xdialog.window != NULL)
+            gtk_widget_destroy(Xdialog.window);
+    }
+    xdialog_set_exit_env(NULL);
+
+    /* Let the closed windows actually vanish */
+    while (gtk_events_pending())
+        gtk_main_iteration();
+
+    /* Drop what was set up on the option descriptors, then them */
+    control_close();
+    result_close();
+    fflush(stdout);
+    fflush(stderr);
+    server_setenv(NULL);
+    serving = FALSE;
+    for (i = 0; i < option_nfds; i++)
+        close(option_fds[i]);
+    option_nfds = 0;
+
+    return status;
+}
+
+int xdialog_server(const char *path, int (*run)(int argc, char *argv[]))
+{
+    int listen_fd, fd, saved[3], saved_cwd, fds[SERVER_NFDS], argc, status, i;
+    unsigned int nfds;
+    char **argv, *payload;
+
+    listen_fd = server_listen(path);
+    if (listen_fd < 0)
+        return 255;
+
+    /* Clients may go away without waiting for their exit code */
+    signal(SIGPIPE, SIG_IGN);
+
+    for (i = 0; i < 3; i++) {
+        saved[i] = dup(i);
+        fcntl(saved[i], F_SETFD, FD_CLOEXEC);
+    }
+    /* Each request runs in its client directory, ours is restored after it */
+    saved_cwd = open(".", O_RDONLY);
+    if (saved_cwd >= 0)
+        fcntl(saved_cwd, F_SETFD, FD_CLOEXEC);
+
+    while (TRUE) {
+        fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            fprintf(stderr, XDIALOG": accept() failed: %s\n", strerror(errno));
+            break;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        if (!server_peer_allowed(fd)) {
+            fprintf(stderr, XDIALOG": request from another user refused\n");
+            close(fd);
+            continue;
+        }
+
+        argv = server_receive(fd, &argc, &payload, fds, &nfds);
+        if (argv != NULL) {
+            status = server_run(run, argc, argv, payload, fds, nfds);
+            for (i = 0; i < 3; i++)
+                dup2(saved[i], i);
+            if (saved_cwd >= 0 && fchdir(saved_cwd) != 0)
+                fprintf(stderr, XDIALOG": can't restore the directory: %s\n",
+                        strerror(errno));
+            if (write(fd, &status, sizeof(status)) != sizeof(status))
+                fprintf(stderr, XDIALOG": client went away\n");
+            g_free(argv);
+            g_free(payload);
+        }
+        close(fd);
+    }
+
+    if (saved_cwd >= 0)
+        close(saved_cwd);
+    close(listen_fd);
+    return 255;
+}
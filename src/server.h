@@ -0,0 +1,59 @@
+/*
+ * Dialog server (Xdialog --server) definitions, shared with Xdialog-client.
+ */
+
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+/* Environment variable holding the server socket path (for the client) */
+#define SERVER_SOCKET		"XDIALOG_SERVER"
+
+/* Program the client falls back to when no server is available */
+#define SERVER_FALLBACK		"Xdialog"
+
+#define SERVER_MAGIC		"XDS3"
+#define SERVER_MAX_REQUEST	(64*1024*1024)
+
+/* Descriptors given to options (--output-fd N), passed along with the
+ * standard ones: the options must be given in full for the client to find
+ * them.
+ */
+#define SERVER_MAX_FDS		4
+#define SERVER_FD_OPTIONS	{ "--output-fd", "--control-fd", NULL }
+
+/* Environment variables of the client which apply to its dialog (the
+ * other ones, e.g. XDIALOG_TRACE, are the server ones).
+ */
+#define SERVER_ENV		{ "LANG", "LANGUAGE", "LC_ALL", "LC_CTYPE", \
+				  "LC_MESSAGES", "XDIALOG_HIGH_DIALOG_COMPAT", \
+				  "XDIALOG_FORCE_AUTOSIZE", "XDIALOG_INFOBOX_TIMEOUT", \
+				  "XDIALOG_NO_GMSGS", "XDIALOG_STATS", NULL }
+
+/* A request is made of this header, sent along with the client stdin,
+ * stdout and stderr descriptors and its "nfds" descriptors numbered "fds"
+ * (SCM_RIGHTS ancillary data, in this order), followed by "length" bytes
+ * holding the client working directory, then its "argc" command line
+ * arguments and its "nenv" SERVER_ENV variables which are set ("NAME=value"
+ * strings), all of them NUL terminated.  The server replies with the
+ * dialog exit code (an int) once the dialog is closed.
+ */
+typedef struct {
+	char		magic[4];
+	unsigned int	argc;
+	unsigned int	nenv;
+	unsigned int	nfds;
+	int		fds[SERVER_MAX_FDS];
+	unsigned int	length;
+} server_request;
+
+int xdialog_server(const char *path, int (*run)(int argc, char *argv[]));
+
+/* Server side descriptor of the client descriptor "fd" for the request
+ * being run (-1 if it was not passed), "fd" itself out of the server mode.
+ */
+int server_fd(int fd);
+
+/* Whether a request of the dialog server is being run */
+int server_serving(void);
+
+#endif /* __SERVER_H__ */
@@ -0,0 +1,235 @@
+/*
+ * Runtime statistics of the streaming boxes (gauge, tailbox and logbox).
+ *
+ * A status line at the bottom of the box shows, every second:
+ *  - the input rate, in bytes and lines (values for the gauge) per second,
+ *  - the backlog: the data waiting to be read on the input (FIONREAD),
+ *  - the coalesced updates: the lines read in between two paints, that
+ *    were not shown on their own,
+ *  - the number of rows (logbox) or lines (tailbox) of the box,
+ *  - the resident memory of Xdialog,
+ *  - the main loop latency: how late a 50 ms timer was dispatched, at
+ *    worst, during the last second.
+ * This tells whether a box falling behind waits for its producer (no
+ * backlog), reads its input too slowly (growing backlog) or spends its time
+ * drawing (high loop latency).  The status line is shown when the
+ * XDIALOG_STATS environment variable is set, and toggled with Ctrl+Shift+S.
+ * The input counters are always kept up to date (two additions per read).
+ */
+
+#include "common.h"
+
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+
+#include "interface.h"
+#include "support.h"
+
+/* Global structures and variables */
+extern Xdialog_data Xdialog;
+
+#define STATS_INTERVAL 1000    /* status line refresh (ms) */
+#define STATS_PROBE    50      /* main loop latency probe period (ms) */
+
+typedef struct {
+    gint       fd;             /* input descriptor */
+    GtkWidget *status_bar;
+    guint      status_id;
+    guint      timer;          /* status line refresh */
+    guint      probe;          /* main loop latency probe */
+    gint64     last_update;
+    gint64     last_probe;
+    gint64     max_latency;
+    guint64    bytes, lines;   /* since the last refresh */
+    guint64    unpainted;      /* lines read since the last paint */
+    guint64    coalesced;      /* total */
+} stats_data;
+
+static stats_data stats = { -1 };
+
+static gint64 stats_now(void)
+{
+#if GLIB_CHECK_VERSION(2,28,0)
+    return g_get_monotonic_time();
+#else
+    GTimeVal now;
+
+    g_get_current_time(&now);
+    return (gint64) now.tv_sec * G_USEC_PER_SEC + now.tv_usec;
+#endif
+}
+
+/* Counts the data read by a box: "lines" are the log lines or gauge values */
+void stats_input(gsize bytes, gint lines)
+{
+    stats.bytes     += bytes;
+    stats.lines     += lines;
+    stats.unpainted += lines;
+}
+
+/* Same, for a chunk of text whose lines are counted */
+void stats_input_text(const gchar *text, gsize bytes)
+{
+    const gchar *p = text, *end = text + bytes;
+    gint lines = 0;
+
+    while ((p = memchr(p, '\n', end - p)) != NULL) {
+        lines++;
+        p++;
+    }
+    stats_input(bytes, lines);
+}
+
+#if GTK_CHECK_VERSION(2,0,0)
+
+static gboolean stats_paint(GtkWidget *widget, gpointer arg, gpointer data)
+{
+    if (stats.unpainted > 1)
+        stats.coalesced += stats.unpainted - 1;
+    stats.unpainted = 0;
+    return FALSE;
+}
+
+static gboolean stats_probe(gpointer data)
+{
+    gint64 now = stats_now();
+    gint64 late = now - stats.last_probe - STATS_PROBE * 1000;
+
+    if (late > stats.max_latency)
+        stats.max_latency = late;
+    stats.last_probe = now;
+    return TRUE;
+}
+
+/* Resident memory, in KiB */
+static glong stats_memory(void)
+{
+    struct rusage usage;
+    glong size, resident = -1;
+    FILE *statm = fopen("/proc/self/statm", "r");
+
+    if (statm != NULL) {
+        if (fscanf(statm, "%ld %ld", &size, &resident) == 2)
+            resident *= sysconf(_SC_PAGESIZE) / 1024;
+        fclose(statm);
+    }
+    if (resident < 0 && getrusage(RUSAGE_SELF, &usage) == 0)
+        resident = usage.ru_maxrss;    /* peak only */
+    return resident;
+}
+
+static gint stats_rows(void)
+{
+    GtkWidget *widget = Xdialog.widget1;
+
+    if (GTK_IS_TREE_VIEW(widget))
+        return gtk_tree_model_iter_n_children(
+                   gtk_tree_view_get_model(GTK_TREE_VIEW(widget)), NULL);
+    if (GTK_IS_TEXT_VIEW(widget))
+        return gtk_text_buffer_get_line_count(
+                   gtk_text_view_get_buffer(GTK_TEXT_VIEW(widget)));
+    return -1;
+}
+
+static gboolean stats_update(gpointer data)
+{
+    gint64 now = stats_now();
+    gdouble seconds = (now - stats.last_update) / (gdouble) G_USEC_PER_SEC;
+    GString *text = g_string_sized_new(128);
+    int backlog = 0;
+    gint rows;
+
+    if (seconds <= 0)
+        seconds = 1;
+    g_string_printf(text, _("in: %.0f B/s, %.0f lines/s"),
+                    stats.bytes / seconds, stats.lines / seconds);
+    if (stats.fd >= 0 && ioctl(stats.fd, FIONREAD, &backlog) == 0)
+        g_string_append_printf(text, _(" | backlog: %d B"), backlog);
+    g_string_append_printf(text, _(" | coalesced: %" G_GUINT64_FORMAT),
+                           stats.coalesced);
+    if ((rows = stats_rows()) >= 0)
+        g_string_append_printf(text, _(" | rows: %d"), rows);
+    g_string_append_printf(text, _(" | RSS: %ld KiB | loop latency: %.1f ms"),
+                           stats_memory(), stats.max_latency / 1000.0);
+
+    gtk_statusbar_pop(GTK_STATUSBAR(stats.status_bar), stats.status_id);
+    gtk_statusbar_push(GTK_STATUSBAR(stats.status_bar), stats.status_id, text->str);
+    g_string_free(text, TRUE);
+
+    stats.bytes = stats.lines = 0;
+    stats.max_latency = 0;
+    stats.last_update = now;
+    return TRUE;
+}
+
+static void stats_show(gboolean show)
+{
+    if (show == (stats.timer != 0))
+        return;
+
+    if (show) {
+        if (stats.status_bar == NULL) {
+            stats.status_bar = gtk_statusbar_new();
+            gtk_box_pack_end(Xdialog.vbox, stats.status_bar, FALSE, FALSE, 0);
+            stats.status_id = gtk_statusbar_get_context_id(
+                                  GTK_STATUSBAR(stats.status_bar), "stats");
+        }
+        gtk_widget_show(stats.status_bar);
+        stats.bytes = stats.lines = 0;
+        stats.max_latency = 0;
+        stats.last_update = stats.last_probe = stats_now();
+        stats.timer = g_timeout_add(STATS_INTERVAL, stats_update, NULL);
+        stats.probe = g_timeout_add(STATS_PROBE, stats_probe, NULL);
+    } else {
+        g_source_remove(stats.timer);
+        g_source_remove(stats.probe);
+        stats.timer = stats.probe = 0;
+        gtk_widget_hide(stats.status_bar);
+    }
+}
+
+static gboolean stats_keypress(GtkWidget *widget, GdkEventKey *event, gpointer data)
+{
+    if ((event->state & (GDK_CONTROL_MASK | GDK_SHIFT_MASK)) ==
+        (GDK_CONTROL_MASK | GDK_SHIFT_MASK) &&
+        (event->keyval == GDK_KEY(S) || event->keyval == GDK_KEY(s))) {
+        stats_show(stats.timer == 0);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+#endif
+
+/* Sets up the statistics of a streaming box reading the "fd" descriptor */
+void stats_init(gint fd)
+{
+#if GTK_CHECK_VERSION(2,0,0)
+    const gchar *env = getenv(STATS_ENV);
+
+    stats_free();
+    stats.fd = fd;
+    g_signal_connect(G_OBJECT(Xdialog.window), "key_press_event",
+                     G_CALLBACK(stats_keypress), NULL);
+    g_signal_connect_after(G_OBJECT(Xdialog.widget1), GTKCOMPAT_DRAW_SIGNAL,
+                           G_CALLBACK(stats_paint), NULL);
+    if (env != NULL && *env != '\0' && strcmp(env, "0") != 0)
+        stats_show(TRUE);
+#endif
+}
+
+/* Called when the box is destroyed (see destroy_event()) */
+void stats_free(void)
+{
+#if GTK_CHECK_VERSION(2,0,0)
+    if (stats.timer != 0) {
+        g_source_remove(stats.timer);
+        g_source_remove(stats.probe);
+    }
+    if (stats.fd >= 0 && Xdialog.window != NULL)
+        g_signal_handlers_disconnect_by_func(G_OBJECT(Xdialog.window),
+                                             G_CALLBACK(stats_keypress), NULL);
+#endif
+    memset(&stats, 0, sizeof(stats));
+    stats.fd = -1;
+}
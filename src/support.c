@@ -6,8 +6,11 @@
 
 #include <errno.h> // my_scanf
 #include <fcntl.h> // my_scanf
+#include <sys/resource.h> // trace_exit
 
 #include "interface.h"
+#include "support.h"
+#include "server.h"
 
 /* Global structures and variables */
 extern Xdialog_data Xdialog;
@@ -18,58 +21,76 @@ extern gboolean dialog_compat;
 /* replace scanf() with a non-blocking function based on read() calls...
    It may not compile on systems lacking lacking errno.h / fcntl.h headers...
    Code adapted from a patch by Rolland Dudemaine.
+   The lines are taken from a line_buffer (see text.c), one per call, and
+   "buffer" must hold MY_SCANF_LENGTH bytes (longer lines are truncated).
  */
+#define MY_SCANF_LENGTH 256
+
+static line_buffer input_buffer;
+
 int my_scanf(char *buffer)
 {
-    static int input_buffer_pos = 0;
-    static char input_buffer[256];
-    char *p;
-    int ret;
+    char *space;
+    size_t size;
+    ssize_t ret;
 
-    fcntl(0, F_SETFL, O_NONBLOCK);
+    if (line_buffer_next(&input_buffer, buffer, MY_SCANF_LENGTH))
+        return 1;
 
-    ret = read(0, (input_buffer + input_buffer_pos), 256 - input_buffer_pos);
-    if ( ret > 0 )
-        input_buffer_pos += ret;
+    fcntl(0, F_SETFL, O_NONBLOCK);
 
-    if ((p = memchr(input_buffer, '\n', input_buffer_pos)) != NULL) {
-        strncpy(buffer, input_buffer, p - input_buffer);
-        buffer[p - input_buffer] = '\0';
-        memmove(input_buffer, p+1, input_buffer_pos - (p - input_buffer));
-        input_buffer_pos -= p - input_buffer + 1;
-    } else {
-        if (ret == 0)
-            return EOF;
-        if (ret == -1) {
-            switch (errno) {
-                /* nothing to read */
-                case EINTR:
-                case EAGAIN:
-                    return 0;
-                /* like EOF */
-                case EINVAL:
-                case EBADF:
-                    return EOF;
-            }
-            }
+    space = line_buffer_space(&input_buffer, &size);
+    ret = read(0, space, size);
+    if (ret > 0) {
+        line_buffer_fill(&input_buffer, ret);
+        return line_buffer_next(&input_buffer, buffer, MY_SCANF_LENGTH);
+    }
+    if (ret == 0)
+        return EOF;
+    switch (errno) {
+        /* nothing to read */
+        case EINTR:
+        case EAGAIN:
+            return 0;
     }
-    return 1;
+    /* like EOF */
+    return EOF;
+}
+
+/* Forget about any pending input (used when stdin is changed) */
+void my_scanf_reset(void)
+{
+    line_buffer_reset(&input_buffer);
 }
 
-/* "\n" to linefeed translation */
+/* Exit routine for errors: when Xdialog runs as a dialog server, only the
+ * current request is aborted (the server then gets status | 0x100 from its
+ * setjmp() call).
+ */
 
-void backslash_n_to_linefeed(char *s0, char *s, int max_len)
+static jmp_buf *exit_env = NULL;
+
+void xdialog_set_exit_env(jmp_buf *env)
 {
-    char *tmp;
+    exit_env = env;
+}
 
-    strncpy(s, s0, max_len);
+void xdialog_exit(int status)
+{
+    if (exit_env != NULL)
+        longjmp(*exit_env, 0x100 | (status & 0xff));
+    exit(status);
+}
 
-    while (strstr(s, "\\n") != NULL) {
-        tmp = strstr(s, "\\n");
-        strcpy(tmp, tmp+1);
-        *tmp = '\n';
-    }
+/* "\n" to linefeed translation (the result is to be freed with g_free) */
 
+gchar *backslash_n_to_linefeed(const gchar *s0)
+{
+    gsize size = strlen(s0) + 1;
+    gchar *s = g_malloc(size);
+
+    normalize_text(s0, s, size, 0);
+    return s;
 }
 
 /*
@@ -78,85 +99,580 @@ void backslash_n_to_linefeed(char *s0, char *s, int max_len)
  * Change embedded "\n" substrings to '\n' characters and tabs to single
  * spaces.  If there are no "\n"s, it will strip all extra spaces, for
  * justification.  If it has "\n"'s, it will preserve extra spaces.  If cr_wrap
- * is set, it will preserve '\n's.
+ * is set, it will preserve '\n's.  The result is to be freed with g_free.
+ */
+gchar *trim_string(const gchar *s0)
+{
+    gsize size = strlen(s0) + 1;
+    gchar *s = g_malloc(size);
+
+    normalize_text(s0, s, size,
+                   NORMALIZE_TRIM | (Xdialog.cr_wrap ? NORMALIZE_CR_WRAP : 0));
+    return s;
+}
+
+/* List items storage: Xdialog.array only holds the offsets and lengths of
+ * the item strings, which are stored into a single arena (Xdialog.list_strings)
+ * that starts with the empty string.  Names and help texts are interned, so
+ * that repeated ones (e.g. empty or generic help texts) are stored once; tags
+ * are unique most of the time and are just appended.
+ */
+
+static GHashTable *interned = NULL;    /* arena offsets hashed on their string */
+static GHashTable *tag_index = NULL;   /* tag arena offset -> item index + 1 */
+static gint list_elements = 0;
+
+/* tag_index key standing for lookup_tag, a string out of the arena */
+#define TAG_LOOKUP G_MAXUINT
+static const gchar *lookup_tag = NULL;
+static gboolean tag_duplicates = FALSE;
+
+static guint interned_hash(gconstpointer key)
+{
+    return g_str_hash(list_string(GPOINTER_TO_UINT(key)));
+}
+
+static gboolean interned_equal(gconstpointer a, gconstpointer b)
+{
+    return strcmp(list_string(GPOINTER_TO_UINT(a)),
+                  list_string(GPOINTER_TO_UINT(b))) == 0;
+}
+
+/* The tag index is keyed on the arena offsets of the tags, so that it stays
+ * valid when the arena grows, and is kept up to date as items are set (the
+ * last item having a tag is the one found).
  */
-void trim_string(char *s0, char *s, int max_len)
+static const gchar *tag_string(gconstpointer key)
 {
-    char *p1;
-    char *p = s;
-    int has_newlines = 0;
+    guint offset = GPOINTER_TO_UINT(key);
 
-    strncpy(s, s0, max_len);
+    return offset == TAG_LOOKUP ? lookup_tag : list_string(offset);
+}
 
-    if (strstr(s, "\\n")) {
-        has_newlines = 1;
+static guint tag_hash(gconstpointer key)
+{
+    return g_str_hash(tag_string(key));
+}
+
+static gboolean tag_equal(gconstpointer a, gconstpointer b)
+{
+    return strcmp(tag_string(a), tag_string(b)) == 0;
+}
+
+static void tag_index_add(gint i)
+{
+    gpointer key = GUINT_TO_POINTER(Xdialog.array[i].tag);
+    gpointer found;
+
+    if (Xdialog.array[i].tag_len == 0)
+        return;
+    if (g_hash_table_lookup_extended(tag_index, key, NULL, &found)) {
+        tag_duplicates = TRUE;
+        if (GPOINTER_TO_INT(found) > i + 1)
+            return;    /* a later item has it */
     }
+    g_hash_table_replace(tag_index, key, GINT_TO_POINTER(i + 1));
+}
 
-    while (*p != '\0')
-    {
-        if (*p == '\t') {
-            *p = ' ';
-        }
-        if (*p == '\\' && *(p + 1) == 'n') {
-            *s++ = '\n';
-            p += 2;
-            p1 = p;
-            /*
-             * Handle end of lines intelligently.  If '\n' follows "\n" then
-             * ignore the '\n'.  This eliminates the need escape the '\n'
-             * character (no need to use "\n\").
-             */
-            while (*p1 == ' ')
-                p1++;
-            if (*p1 == '\n')
-                p = p1 + 1;
-        } else {
-            if (has_newlines) {    /* If prompt contains "\n" strings */
-                if (*p == '\n') {
-                    if (Xdialog.cr_wrap)
-                        *s++ = *p++;
-                    else {
-                        /* Replace the '\n' with a space if cr_wrap is not set */
-                        if (*(s - 1) != ' ')
-                            *s++ = ' ';
-                        p++;
-                    }
-                } else        /* If *p != '\n' */
-                    *s++ = *p++;
-            } else {        /* If there are no "\n" strings */
-                if (*p == ' ') {
-                    if (*(s - 1) != ' ') {
-                        *s++ = ' ';
-                        p++;
-                    } else
-                        p++;
-                } else if (*p == '\n') {
-                    if (Xdialog.cr_wrap)
-                        *s++ = *p++;
-                    else if (*(s - 1) != ' ') {
-                        /* Strip '\n's if cr_wrap is not set. */
-                        *s++ = ' ';
-                        p++;
-                    } else
-                        p++;
-                } else
-                    *s++ = *p++;
+static void tag_index_remove(gint i)
+{
+    gpointer key = GUINT_TO_POINTER(Xdialog.array[i].tag);
+    const gchar *tag;
+    gint j;
+
+    if (Xdialog.array[i].tag_len == 0 ||
+        GPOINTER_TO_INT(g_hash_table_lookup(tag_index, key)) != i + 1)
+        return;
+    g_hash_table_remove(tag_index, key);
+
+    /* an earlier item may have the same tag (only looked for if need be) */
+    if (tag_duplicates) {
+        tag = list_string(Xdialog.array[i].tag);
+        for (j = list_elements - 1; j >= 0; j--) {
+            if (j != i && Xdialog.array[j].tag_len > 0 &&
+                strcmp(item_tag(&Xdialog.array[j]), tag) == 0) {
+                g_hash_table_insert(tag_index, GUINT_TO_POINTER(Xdialog.array[j].tag),
+                                    GINT_TO_POINTER(j + 1));
+                break;
             }
         }
     }
+}
+
+static void list_store_string(const gchar *s, gboolean intern,
+                              guint *offset, guint *length)
+{
+    gsize n = (s != NULL ? strlen(s) : 0);
+    gpointer key, found;
+
+    *length = n;
+    *offset = 0;
+    if (n == 0)
+        return;
 
-    *s = '\0';
+    *offset = Xdialog.list_strings->len;
+    g_byte_array_append(Xdialog.list_strings, (const guint8 *) s, n + 1);
+    if (!intern)
+        return;
+
+    key = GUINT_TO_POINTER(*offset);
+    if (g_hash_table_lookup_extended(interned, key, &found, NULL)) {
+        g_byte_array_set_size(Xdialog.list_strings, *offset);
+        *offset = GPOINTER_TO_UINT(found);
+    } else {
+        g_hash_table_insert(interned, key, key);
+    }
 }
 
 /* Array allocation function */
 
 void Xdialog_array(gint elements)
 {
-    Xdialog.array = g_malloc0((elements+1)*sizeof(listname));
+    Xdialog.array = g_try_new0(listname, elements+1);
     if (Xdialog.array == NULL) {
         fprintf(stderr,
              XDIALOG": problem while allocating memory, exiting !\n");
-            exit(255);
+            xdialog_exit(255);
     }
     Xdialog.array[elements].state = -1;
+    list_elements = elements;
+
+    Xdialog.list_strings = g_byte_array_sized_new(elements * 16 + 1);
+    g_byte_array_append(Xdialog.list_strings, (const guint8 *) "", 1);
+    interned = g_hash_table_new(interned_hash, interned_equal);
+}
+
+/* Sets the strings of the i-th item of the list (tips may be NULL) */
+void set_list_item(gint i, const gchar *tag, const gchar *name, const gchar *tips)
+{
+    listname *item = &Xdialog.array[i];
+
+    if (tag_index != NULL)
+        tag_index_remove(i);
+    item->state = 0;
+    list_store_string(tag, FALSE, &item->tag, &item->tag_len);
+    list_store_string(name, TRUE, &item->name, &item->name_len);
+    list_store_string(tips, TRUE, &item->tips, &item->tips_len);
+    if (tag_index != NULL)
+        tag_index_add(i);
+}
+
+/* Appends an item to the list (--control-fd), returning its index */
+gint add_list_item(const gchar *tag, const gchar *name, const gchar *tips)
+{
+    gint i = list_elements++;
+
+    Xdialog.array = g_renew(listname, Xdialog.array, list_elements + 1);
+    Xdialog.array[list_elements].state = -1;
+    Xdialog.array[i].tag_len = 0;    /* not in the tag index yet */
+    set_list_item(i, tag, name, tips);
+    return i;
+}
+
+void free_list(void)
+{
+    if (Xdialog.array != NULL) {
+        g_free(Xdialog.array);
+        Xdialog.array = NULL;
+    }
+    if (Xdialog.list_strings != NULL) {
+        g_byte_array_free(Xdialog.list_strings, TRUE);
+        Xdialog.list_strings = NULL;
+    }
+    if (interned != NULL) {
+        g_hash_table_destroy(interned);
+        interned = NULL;
+    }
+    if (tag_index != NULL) {
+        g_hash_table_destroy(tag_index);
+        tag_index = NULL;
+    }
+    tag_duplicates = FALSE;
+    if (Xdialog.tree_parent != NULL) {
+        g_free(Xdialog.tree_parent);
+        Xdialog.tree_parent = Xdialog.tree_next = NULL;
+    }
+}
+
+/* Allocates the tree links of the list items (for the treeview) */
+void Xdialog_tree(gint elements)
+{
+    Xdialog.tree_parent = g_try_new(gint, 2 * elements + 1);
+    if (Xdialog.tree_parent == NULL) {
+        fprintf(stderr,
+             XDIALOG": problem while allocating memory, exiting !\n");
+            xdialog_exit(255);
+    }
+    Xdialog.tree_next = Xdialog.tree_parent + elements;
+}
+
+/* Links the i-th item of the treeview, the items being given in order with
+ * their depth (the one of the previous item being prev_depth): the parent of
+ * an item is found by going up the ancestors of the previous one, which also
+ * gives its previous sibling.  Returns FALSE if the depth grows by more than
+ * one level.
+ */
+gboolean set_tree_item(gint i, gint depth, gint prev_depth)
+{
+    gint sibling = i - 1;
+
+    Xdialog.tree_next[i] = -1;
+    if (i == 0) {
+        Xdialog.tree_parent[i] = -1;
+        return TRUE;
+    }
+    if (depth > prev_depth + 1)
+        return FALSE;
+    if (depth == prev_depth + 1) {
+        Xdialog.tree_parent[i] = i - 1;
+        return TRUE;
+    }
+    for (; prev_depth > depth && Xdialog.tree_parent[sibling] >= 0; prev_depth--)
+        sibling = Xdialog.tree_parent[sibling];
+    Xdialog.tree_parent[i] = Xdialog.tree_parent[sibling];
+    Xdialog.tree_next[sibling] = i;
+    return TRUE;
+}
+
+/* TRUE if the i-th treeview item has children (which then follow it) */
+gboolean tree_item_has_children(gint i)
+{
+    return Xdialog.array[i+1].state != -1 && Xdialog.tree_parent[i+1] == i;
+}
+
+/* Returns the index of the item with the given tag (the last one if several
+ * items share it), or -1.  The tags index is built by the first call, once
+ * the list is filled, so that the --default-item and other selections by tag
+ * cost a single hash lookup.
+ */
+gint find_list_item(const gchar *tag)
+{
+    gint i;
+
+    if (Xdialog.array == NULL || tag == NULL || *tag == '\0')
+        return -1;
+
+    if (tag_index == NULL) {
+        tag_index = g_hash_table_new(tag_hash, tag_equal);
+        for (i = 0; i < list_elements; i++)
+            tag_index_add(i);
+    }
+    lookup_tag = tag;
+    i = GPOINTER_TO_INT(g_hash_table_lookup(tag_index, GUINT_TO_POINTER(TAG_LOOKUP))) - 1;
+    lookup_tag = NULL;
+    return i;
+}
+
+/* Results output: the fields of a result (an entry text, a selected tag...)
+ * are gathered into a buffer, written at once by result_end() in the
+ * --output-format format:
+ *  - text: the fields separated with Xdialog.separator, and a linefeed,
+ *  - nul: each field terminated with a NUL character,
+ *  - json: a JSON array of strings, and a linefeed.
+ * An empty result (e.g. an empty list selection) is only output in JSON.
+ */
+static GString *result = NULL;
+static gint result_fields = 0;
+
+void result_begin(void)
+{
+    if (result == NULL)
+        result = g_string_sized_new(1024);
+    g_string_truncate(result, 0);
+    result_fields = 0;
+    if (Xdialog.output_format == OUTPUT_JSON)
+        g_string_append_c(result, '[');
+}
+
+static void json_string(GString *s, const gchar *text)
+{
+    const guchar *c;
+
+    g_string_append_c(s, '"');
+    for (c = (const guchar *) text; *c != '\0'; c++) {
+        switch (*c) {
+            case '"':  g_string_append(s, "\\\""); break;
+            case '\\': g_string_append(s, "\\\\"); break;
+            case '\n': g_string_append(s, "\\n"); break;
+            case '\r': g_string_append(s, "\\r"); break;
+            case '\t': g_string_append(s, "\\t"); break;
+            default:
+                if (*c < 0x20)
+                    g_string_append_printf(s, "\\u%04x", *c);
+                else
+                    g_string_append_c(s, *c);
+        }
+    }
+    g_string_append_c(s, '"');
+}
+
+void result_add(const gchar *field)
+{
+    switch (Xdialog.output_format) {
+        case OUTPUT_NUL:
+            g_string_append(result, field);
+            g_string_append_c(result, '\0');
+            break;
+        case OUTPUT_JSON:
+            if (result_fields > 0)
+                g_string_append_c(result, ',');
+            json_string(result, field);
+            break;
+        default:
+            if (result_fields > 0)
+                g_string_append(result, Xdialog.separator);
+            g_string_append(result, field);
+    }
+    result_fields++;
+}
+
+void result_add_printf(const gchar *format, ...)
+{
+    va_list args;
+    gchar *field;
+
+    va_start(args, format);
+    field = g_strdup_vprintf(format, args);
+    va_end(args);
+    result_add(field);
+    g_free(field);
+}
+
+void result_end(void)
+{
+    if (Xdialog.output_format == OUTPUT_JSON)
+        g_string_append(result, "]\n");
+    else if (Xdialog.output_format == OUTPUT_TEXT && result_fields > 0)
+        g_string_append_c(result, '\n');
+    if (result->len > 0)
+        fwrite(result->str, 1, result->len, Xdialog.output);
+}
+
+/* --output-fd: the results stream of a file descriptor, fully buffered and
+ * only flushed by result_flush() (or at exit).  The stream is kept for the
+ * next dialogs of the script mode, so that a descriptor never gets two
+ * streams with their own buffers, and closed at the end of each request of
+ * the server mode, whose descriptor comes from the client (see server_fd()).
+ * The stream is opened on a duplicate, so that closing it leaves the given
+ * descriptor alone.
+ */
+static FILE *result_fd_stream = NULL;
+static long result_fd = -1;
+
+FILE *result_stream(const gchar *fd)
+{
+    gchar *end;
+    long n = strtol(fd, &end, 10);
+    int own;
+
+    if (*fd == '\0' || *end != '\0' || n < 0 || n > G_MAXINT) {
+        fprintf(stderr, XDIALOG": bad output file descriptor: %s\n", fd);
+        xdialog_exit(255);
+    }
+    if (result_fd_stream != NULL && result_fd == n)
+        return result_fd_stream;
+    result_close();
+    if ((own = server_fd((int) n)) < 0) {
+        fprintf(stderr, XDIALOG": output file descriptor %s not passed by "
+                        "the client (use --output-fd in full)\n", fd);
+        xdialog_exit(255);
+    }
+    if ((own = dup(own)) >= 0) {
+        fcntl(own, F_SETFD, FD_CLOEXEC);
+        if ((result_fd_stream = fdopen(own, "w")) == NULL)
+            close(own);
+    }
+    if (result_fd_stream == NULL) {
+        fprintf(stderr, XDIALOG": can't write to file descriptor %s: %s\n",
+                fd, strerror(errno));
+        xdialog_exit(255);
+    }
+    setvbuf(result_fd_stream, NULL, _IOFBF, BUFSIZ);
+    result_fd = n;
+    return result_fd_stream;
+}
+
+/* Flushes and closes the --output-fd stream (end of a server request) */
+void result_close(void)
+{
+    if (result_fd_stream != NULL) {
+        fclose(result_fd_stream);
+        result_fd_stream = NULL;
+        result_fd = -1;
+    }
+}
+
+void result_flush(void)
+{
+    if (result_fd_stream != NULL)
+        fflush(result_fd_stream);
+}
+
+/* Outputs a single field result */
+void result_print(const gchar *field)
+{
+    result_begin();
+    result_add(field);
+    result_end();
+}
+
+void result_print_printf(const gchar *format, ...)
+{
+    va_list args;
+    gchar *field;
+
+    va_start(args, format);
+    field = g_strdup_vprintf(format, args);
+    va_end(args);
+    result_print(field);
+    g_free(field);
+}
+
+/* Startup tracing: when the XDIALOG_TRACE environment variable holds a file
+ * name ("-" for stderr), timestamped events for the startup phases are
+ * written into it using the Chrome trace event format (one event per line,
+ * so that the file can be loaded in chrome://tracing or grep'ed as well).
+ */
+
+static FILE *trace_file = NULL;
+
+static gint64 trace_now(void)
+{
+#if GLIB_CHECK_VERSION(2,28,0)
+    return g_get_monotonic_time();
+#else
+    GTimeVal now;
+
+    g_get_current_time(&now);
+    return (gint64) now.tv_sec * G_USEC_PER_SEC + now.tv_usec;
+#endif
+}
+
+/* Records the CPU time and peak memory use of the process when it exits */
+static void trace_exit(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return;
+    fprintf(trace_file, "{\"name\": \"rusage\", \"cat\": \"exit\", "
+                        "\"ph\": \"i\", \"ts\": %lld, \"pid\": %d, \"tid\": 1, "
+                        "\"args\": {\"utime\": %lld, \"stime\": %lld, \"maxrss\": %ld}},\n",
+            (long long) trace_now(), (int) getpid(),
+            (long long) usage.ru_utime.tv_sec * G_USEC_PER_SEC + usage.ru_utime.tv_usec,
+            (long long) usage.ru_stime.tv_sec * G_USEC_PER_SEC + usage.ru_stime.tv_usec,
+            usage.ru_maxrss);
+    fflush(trace_file);
+}
+
+void trace_init(void)
+{
+    char *name = getenv(TRACE_FILE);
+
+    if (trace_file != NULL || name == NULL || *name == '\0')
+        return;
+
+    if (strcmp(name, "-") == 0)
+        trace_file = stderr;
+    else if ((trace_file = fopen(name, "w")) == NULL) {
+        fprintf(stderr, XDIALOG": can't open trace file %s: %s\n",
+                name, strerror(errno));
+        return;
+    }
+    fprintf(trace_file, "[\n");
+    /* The wall clock time matching the trace clock, for the events to be
+     * compared with the ones of other programs (see bench/bench.sh)
+     */
+    fprintf(trace_file, "{\"name\": \"clock\", \"cat\": \"startup\", "
+                        "\"ph\": \"i\", \"ts\": %lld, \"pid\": %d, \"tid\": 1, "
+                        "\"args\": {\"real\": %lld}},\n",
+            (long long) trace_now(), (int) getpid(),
+#if GLIB_CHECK_VERSION(2,28,0)
+            (long long) g_get_real_time()
+#else
+            (long long) trace_now()
+#endif
+            );
+    atexit(trace_exit);
+}
+
+void trace_event(const gchar *name, gchar phase)
+{
+    if (trace_file == NULL)
+        return;
+
+    fprintf(trace_file, "{\"name\": \"%s\", \"cat\": \"startup\", "
+                        "\"ph\": \"%c\", \"ts\": %lld, \"pid\": %d, \"tid\": 1},\n",
+            name, phase, (long long) trace_now(), (int) getpid());
+    fflush(trace_file);
+}
+
+#if GTK_CHECK_VERSION(2,0,0)
+static void trace_map(GtkWidget *widget, gpointer data)
+{
+    trace_event("map", 'i');
+    g_signal_handlers_disconnect_by_func(G_OBJECT(widget),
+                                         G_CALLBACK(trace_map), data);
+}
+
+static gboolean trace_draw(GtkWidget *widget, gpointer arg, gpointer data)
+{
+    trace_event("draw", 'i');
+    g_signal_handlers_disconnect_by_func(G_OBJECT(widget),
+                                         G_CALLBACK(trace_draw), data);
+    return FALSE;
+}
+#endif
+
+/* Update tracing: the data read by the gauge, tailbox and logbox is recorded
+ * as "input" events (with the number of values, bytes or lines), and the next
+ * draw of the box as a "paint" event, for the input-to-paint latency to be
+ * measured (see bench/bench.sh).  These events are not flushed one by one.
+ */
+static gboolean trace_pending = FALSE;
+
+void trace_input(gint count)
+{
+    if (trace_file == NULL)
+        return;
+
+    fprintf(trace_file, "{\"name\": \"input\", \"cat\": \"update\", "
+                        "\"ph\": \"i\", \"ts\": %lld, \"pid\": %d, \"tid\": 1, "
+                        "\"args\": {\"count\": %d}},\n",
+            (long long) trace_now(), (int) getpid(), count);
+    trace_pending = TRUE;
+}
+
+#if GTK_CHECK_VERSION(2,0,0)
+static gboolean trace_paint(GtkWidget *widget, gpointer arg, gpointer data)
+{
+    if (trace_pending) {
+        fprintf(trace_file, "{\"name\": \"paint\", \"cat\": \"update\", "
+                            "\"ph\": \"i\", \"ts\": %lld, \"pid\": %d, \"tid\": 1},\n",
+                (long long) trace_now(), (int) getpid());
+        trace_pending = FALSE;
+    }
+    return FALSE;
+}
+#endif
+
+/* Records the first map and the first draw of a window about to be shown,
+ * and the draws of the window and of its main widget following an input.
+ */
+void trace_window(GtkWidget *window)
+{
+#if GTK_CHECK_VERSION(2,0,0)
+    if (trace_file == NULL || window == NULL)
+        return;
+
+    g_signal_connect(G_OBJECT(window), "map",
+                     G_CALLBACK(trace_map), NULL);
+    g_signal_connect(G_OBJECT(window), GTKCOMPAT_DRAW_SIGNAL,
+                     G_CALLBACK(trace_draw), NULL);
+    g_signal_connect_after(G_OBJECT(window), GTKCOMPAT_DRAW_SIGNAL,
+                           G_CALLBACK(trace_paint), NULL);
+    if (Xdialog.widget1 != NULL)
+        g_signal_connect_after(G_OBJECT(Xdialog.widget1), GTKCOMPAT_DRAW_SIGNAL,
+                               G_CALLBACK(trace_paint), NULL);
+#endif
 }
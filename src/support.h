@@ -2,8 +2,84 @@
  * defines for the support functions.
  */
 
-void backslash_n_to_linefeed(char *s0, char *s, int max_len);
-void trim_string(char *s0, char *s, int max_len);
+#include <setjmp.h>
+
+#include "text.h"
+
+gchar *backslash_n_to_linefeed(const gchar *s0);
+gchar *trim_string(const gchar *s0);
 void Xdialog_array(gint elements);
+void set_list_item(gint i, const gchar *tag, const gchar *name, const gchar *tips);
+gint add_list_item(const gchar *tag, const gchar *name, const gchar *tips);
+void free_list(void);
+gint find_list_item(const gchar *tag);
+void Xdialog_tree(gint elements);
+gboolean set_tree_item(gint i, gint depth, gint prev_depth);
+gboolean tree_item_has_children(gint i);
 int my_scanf(char *buf);
+void my_scanf_reset(void);
+void xdialog_exit(int status);
+void xdialog_set_exit_env(jmp_buf *env);
+
+/* Results output (--output-format) */
+void result_begin(void);
+void result_add(const gchar *field);
+void result_add_printf(const gchar *format, ...) G_GNUC_PRINTF(1, 2);
+void result_end(void);
+void result_print(const gchar *field);
+void result_print_printf(const gchar *format, ...) G_GNUC_PRINTF(1, 2);
+FILE *result_stream(const gchar *fd);
+void result_flush(void);
+void result_close(void);
+
+/* Startup tracing (XDIALOG_TRACE) */
+#define trace_begin(name)  trace_event(name, 'B')
+#define trace_end(name)    trace_event(name, 'E')
+
+void trace_init(void);
+void trace_event(const gchar *name, gchar phase);
+void trace_input(gint count);
+void trace_window(GtkWidget *window);
+
+/* Runtime statistics of the streaming boxes (XDIALOG_STATS), see stats.c */
+void stats_init(gint fd);
+void stats_input(gsize bytes, gint lines);
+void stats_input_text(const gchar *text, gsize bytes);
+void stats_free(void);
+
+/* Logbox input, read and parsed by a reader thread, see logbox.c */
+typedef struct {
+    gchar    *text;            /* without the colour sequences (NULL for
+                                  the end of a truncated last line) */
+    GdkColor *fgcolor, *bgcolor;
+    gchar     stamp[24];       /* --time-stamp, --date-stamp */
+    gsize     length;          /* bytes read */
+} logbox_row;
+
+void logbox_start(FILE *logged);
+gboolean logbox_next(logbox_row *row);
+void logbox_stop(void);
+
+/* Main loop watchdog (XDIALOG_WATCHDOG), see watchdog.c */
+#define watched_timeout_add(interval, function, data) \
+    watchdog_timeout_add(interval, (GSourceFunc) (function), data, #function)
+
+void watchdog_init(void);
+void watchdog_start(void);
+void watchdog_stop(void);
+void watchdog_begin(const gchar *name);
+void watchdog_end(void);
+guint watchdog_timeout_add(guint interval, GSourceFunc function, gpointer data,
+                           const gchar *name);
+
+/* List items read from a file (--items-from), see items.c */
+gint read_items(const gchar *path, gint parameters, const gchar * const *names);
+void free_items(void);
+
+/* Control channel (--control-fd), see control.c */
+void control_open(const gchar *fd);
+void control_start(void);
+void control_close(void);
 
+/* Script mode (--script), see script.c */
+int xdialog_script(const char *path, int (*run)(int argc, char *argv[]));
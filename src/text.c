@@ -0,0 +1,232 @@
+/*
+ * Text processing functions for Xdialog.
+ *
+ * These routines work on plain C strings and buffers, with no GTK+ (nor
+ * GLib) dependency, so that they can be built into the text benchmark (see
+ * bench/textbench.c).  They all run in linear time: each byte of their input
+ * is looked at a bounded number of times, whatever the line lengths.
+ */
+
+#include <string.h>
+
+#include "text.h"
+
+/*
+ * Single pass "\n" and white space normaliser, shared by trim_string() and
+ * backslash_n_to_linefeed().  The result is written into dst (at most
+ * dst_size bytes including the terminating NUL) and its length returned.
+ * The output is never longer than the input, so a dst of strlen(src)+1
+ * bytes is always large enough.
+ *
+ * Without NORMALIZE_TRIM, embedded "\n" substrings are merely changed into
+ * '\n' characters.  With NORMALIZE_TRIM, the trim_string() rules apply,
+ * NORMALIZE_CR_WRAP telling whether real '\n's are preserved.
+ */
+size_t normalize_text(const char *src, char *dst, size_t dst_size, int flags)
+{
+    const char *p = src, *p1;
+    char *s = dst, *end;
+    int has_newlines, cr_wrap;
+    char c;
+
+    if (dst_size == 0)
+        return 0;
+    end = dst + dst_size - 1;
+
+    if (!(flags & NORMALIZE_TRIM)) {
+        while (*p != '\0' && s < end) {
+            if (*p == '\\' && *(p + 1) == 'n') {
+                *s++ = '\n';
+                p += 2;
+            } else
+                *s++ = *p++;
+        }
+        *s = '\0';
+        return s - dst;
+    }
+
+    has_newlines = (strstr(src, "\\n") != NULL);
+    cr_wrap = (flags & NORMALIZE_CR_WRAP) != 0;
+
+    /* Was the last character written a space ? */
+#define LAST_IS_SPACE (s > dst && *(s - 1) == ' ')
+
+    while (*p != '\0' && s < end)
+    {
+        c = (*p == '\t') ? ' ' : *p;
+        if (c == '\\' && *(p + 1) == 'n') {
+            *s++ = '\n';
+            p += 2;
+            p1 = p;
+            /*
+             * Handle end of lines intelligently.  If '\n' follows "\n" then
+             * ignore the '\n'.  This eliminates the need escape the '\n'
+             * character (no need to use "\n\").
+             */
+            while (*p1 == ' ')
+                p1++;
+            if (*p1 == '\n')
+                p = p1 + 1;
+        } else if (c == '\n') {
+            if (cr_wrap)
+                *s++ = c;
+            else if (!LAST_IS_SPACE)
+                /* Replace the '\n' with a space if cr_wrap is not set */
+                *s++ = ' ';
+            p++;
+        } else if (c == ' ' && !has_newlines) {
+            /* Strip extra spaces when there are no "\n" strings */
+            if (!LAST_IS_SPACE)
+                *s++ = ' ';
+            p++;
+        } else {
+            *s++ = c;
+            p++;
+        }
+    }
+#undef LAST_IS_SPACE
+
+    *s = '\0';
+    return s - dst;
+}
+
+/* Strips the "ESC[...m" colour sequences of a logbox line in place (an
+ * unterminated sequence ends the line), returning its new length.
+ */
+size_t remove_vt_sequences(char *str)
+{
+    char *p = str, *q = str, *m;
+
+    while (*p != '\0') {
+        if (p[0] == '\033' && p[1] == '[') {
+            if ((m = strchr(p + 2, 'm')) == NULL)
+                break;
+            p = m + 1;
+        } else {
+            *q++ = *p++;
+        }
+    }
+    *q = '\0';
+    return q - str;
+}
+
+/* Greedy word wrapping: the spaces on which the lines get wider than
+ * max_width are turned into linefeeds, char_width() giving the width of each
+ * character.  The line widths are summed up as the text is scanned, instead
+ * of measuring each line prefix again.
+ */
+void wrap_words(char *str, int max_width,
+                int (*char_width)(unsigned char c, void *data), void *data)
+{
+    char *p, *last_space = NULL;
+    int width = 0, after_space = 0, w;
+
+    for (p = str; *p != '\0'; p++) {
+        if (*p == '\n') {
+            width = after_space = 0;
+            last_space = NULL;
+            continue;
+        }
+        w = char_width((unsigned char) *p, data);
+        width += w;
+        after_space += w;
+        if (width >= max_width && last_space != NULL) {
+            /* the current word goes on the next line */
+            *last_space = '\n';
+            width = after_space;
+            last_space = NULL;
+        }
+        if (*p == ' ') {
+            last_space = p;
+            after_space = 0;
+        }
+    }
+}
+
+/* Line buffer: the data read is appended at "end" and the lines are taken
+ * from "start", so that taking a line costs its length only.  The pending
+ * data is moved back to the beginning of the buffer when there is no room
+ * left.  Lines that do not fit into the caller's buffer are truncated, their
+ * remaining bytes being skipped.
+ */
+
+/* Returns where (and *size how many) bytes may be read into the buffer */
+char *line_buffer_space(line_buffer *b, size_t *size)
+{
+    if (b->start == b->end) {
+        b->start = b->end = 0;
+    } else if (b->end == sizeof(b->data) && b->start > 0) {
+        memmove(b->data, b->data + b->start, b->end - b->start);
+        b->end  -= b->start;
+        b->start = 0;
+    }
+    *size = sizeof(b->data) - b->end;
+    return b->data + b->end;
+}
+
+/* Takes into account "length" bytes read at line_buffer_space() */
+void line_buffer_fill(line_buffer *b, size_t length)
+{
+    b->end += length;
+}
+
+/* Copies the next line (without its linefeed) into "line", returning 0 if
+ * there is no complete line yet.
+ */
+int line_buffer_next(line_buffer *b, char *line, size_t size)
+{
+    char *p;
+    size_t n;
+
+    for (;;) {
+        p = memchr(b->data + b->start, '\n', b->end - b->start);
+        n = (p != NULL ? p : b->data + b->end) - (b->data + b->start);
+        if (b->skipping) {
+            b->start += n;
+            if (p == NULL)
+                return 0;
+            b->start++;
+            b->skipping = 0;
+            continue;
+        }
+        if (p == NULL && n < size - 1 && n < sizeof(b->data))
+            return 0;
+        if (p == NULL || n > size - 1) {
+            /* too long: truncated, and the rest is skipped */
+            if (n > size - 1)
+                n = size - 1;
+            b->skipping = 1;
+        }
+        memcpy(line, b->data + b->start, n);
+        line[n] = '\0';
+        b->start += n + !b->skipping;
+        return 1;
+    }
+}
+
+/* Copies the last line, without a linefeed, at the end of the input: returns
+ * 0 if there is none (the rest of a truncated line is dropped).
+ */
+int line_buffer_flush(line_buffer *b, char *line, size_t size)
+{
+    size_t n = b->end - b->start;
+    int skipped = b->skipping;
+
+    b->skipping = 0;
+    if (skipped || n == 0) {
+        b->start = b->end;
+        return 0;
+    }
+    if (n > size - 1)
+        n = size - 1;
+    memcpy(line, b->data + b->start, n);
+    line[n] = '\0';
+    b->start = b->end;
+    return 1;
+}
+
+void line_buffer_reset(line_buffer *b)
+{
+    b->start = b->end = 0;
+    b->skipping = 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * defines for the text processing functions (see text.c).
+ */
+
+#ifndef __TEXT_H__
+#define __TEXT_H__
+
+#include <stddef.h>
+
+/* normalize_text() flags */
+#define NORMALIZE_TRIM     (1 << 0)
+#define NORMALIZE_CR_WRAP  (1 << 1)
+
+size_t normalize_text(const char *src, char *dst, size_t dst_size, int flags);
+size_t remove_vt_sequences(char *str);
+void wrap_words(char *str, int max_width,
+                int (*char_width)(unsigned char c, void *data), void *data);
+
+/* Lines reading from a non-blocking descriptor (see my_scanf()) */
+#define LINE_BUFFER_SIZE 4096
+
+typedef struct {
+    char   data[LINE_BUFFER_SIZE];
+    size_t start;      /* first byte not taken yet */
+    size_t end;        /* end of the data read */
+    int    skipping;   /* rest of a truncated line to be skipped */
+} line_buffer;
+
+char *line_buffer_space(line_buffer *b, size_t *size);
+void line_buffer_fill(line_buffer *b, size_t length);
+int line_buffer_next(line_buffer *b, char *line, size_t size);
+int line_buffer_flush(line_buffer *b, char *line, size_t size);
+void line_buffer_reset(line_buffer *b);
+
+#endif /* __TEXT_H__ */
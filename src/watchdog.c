@@ -0,0 +1,358 @@
+/*
+ * Main loop watchdog (XDIALOG_WATCHDOG).
+ *
+ * A heartbeat timer stamps the time while the GTK+ main loop runs, and a
+ * watchdog thread checks every WATCHDOG_PERIOD ms that the stamp is recent.
+ * When the main thread has not come back to the main loop for longer than
+ * the threshold (XDIALOG_WATCHDOG_MS, WATCHDOG_THRESHOLD by default), the
+ * stall is reported with the name of the source being dispatched (the
+ * timeouts set with watched_timeout_add() and the sections between
+ * watchdog_begin() and watchdog_end()) and a backtrace of the main thread,
+ * taken from a SIGUSR2 handler.  Its duration is reported once the main
+ * thread is back, and a histogram of the stall durations is written at exit.
+ *
+ * The report is appended to the XDIALOG_WATCHDOG file (- for stderr), one
+ * JSON object per line:
+ *
+ *   {"event": "stall", "pid": 123, "source": "progress_timeout",
+ *    "threshold_ms": 250, "backtrace": ["./Xdialog(progress_timeout+0x4c) ..."]}
+ *   {"event": "stall_end", "pid": 123, "source": "progress_timeout", "duration_ms": 1830}
+ *   {"event": "histogram", "pid": 123, "count": 1, "total_ms": 1830, "max_ms": 1830,
+ *    "buckets": {"0": 0, "500": 0, "1000": 1, "2000": 0, "5000": 0, "10000": 0}}
+ *
+ * Without XDIALOG_WATCHDOG, no thread is started and the watched timeouts
+ * are plain timeouts.
+ */
+
+#include "common.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+
+#include "interface.h"
+#include "support.h"
+
+#define WATCHDOG_HEARTBEAT  100     /* main loop heartbeat period (ms) */
+#define WATCHDOG_PERIOD     50      /* watchdog thread check period (ms) */
+#define WATCHDOG_THRESHOLD  250     /* default stall threshold (ms) */
+#define WATCHDOG_FRAMES     32      /* backtrace depth */
+
+/* Histogram buckets lower bounds (ms), the stalls being at least as long as
+ * the threshold
+ */
+static const gint buckets[] = { 0, 500, 1000, 2000, 5000, 10000 };
+#define WATCHDOG_BUCKETS (sizeof(buckets) / sizeof(buckets[0]))
+
+typedef struct {
+    GSourceFunc  function;
+    gpointer     data;
+    const gchar *name;
+} watched_source;
+
+#if GLIB_CHECK_VERSION(2,32,0)
+
+static FILE *log_file = NULL;
+static gint threshold = WATCHDOG_THRESHOLD;
+static pthread_t main_thread;
+static GThread *thread = NULL;
+static guint heartbeat = 0;
+
+/* Shared with the watchdog thread (the reports are written out of the lock) */
+static GMutex lock;
+static gboolean stopping = FALSE;      /* at exit */
+static gboolean armed = FALSE;         /* main loop (or a section) running */
+static gboolean section_armed;         /* armed before watchdog_begin() */
+static gint64 last_beat;
+static const gchar *source = NULL;     /* source being dispatched */
+static gint64 stall_since = 0;         /* last beat before the stall */
+static const gchar *stall_source;
+
+/* Histogram, only updated by the watchdog thread (then read at exit) */
+static guint counts[WATCHDOG_BUCKETS];
+static guint stalls = 0;
+static gint64 total_ms = 0, max_ms = 0;
+
+/* Backtrace taken by the signal handler in the main thread */
+static void *frames[WATCHDOG_FRAMES];
+static volatile sig_atomic_t nframes = -1;
+
+static void watchdog_backtrace(int sig)
+{
+    int saved_errno = errno;
+
+#ifdef HAVE_EXECINFO_H
+    nframes = backtrace(frames, WATCHDOG_FRAMES);
+#else
+    nframes = 0;
+#endif
+    errno = saved_errno;
+}
+
+/* Writes a JSON string */
+static void watchdog_string(const gchar *str)
+{
+    fputc('"', log_file);
+    for (; *str != '\0'; str++) {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', log_file);
+        if ((guchar) *str >= ' ')
+            fputc(*str, log_file);
+    }
+    fputc('"', log_file);
+}
+
+/* Called by the watchdog thread when a stall is detected */
+static void watchdog_stall(const gchar *name)
+{
+    gchar **symbols = NULL;
+    gint i, n;
+
+    /* ask the main thread for its backtrace, and wait (a bit) for it */
+    nframes = -1;
+    if (pthread_kill(main_thread, SIGUSR2) == 0)
+        for (i = 0; i < 100 && nframes < 0; i++)
+            g_usleep(1000);
+    n = nframes;
+#ifdef HAVE_EXECINFO_H
+    if (n > 0)
+        symbols = backtrace_symbols(frames, n);
+#endif
+
+    fprintf(log_file, "{\"event\": \"stall\", \"pid\": %d, \"source\": ",
+            (int) getpid());
+    watchdog_string(name);
+    fprintf(log_file, ", \"threshold_ms\": %d, \"backtrace\": [", threshold);
+    for (i = 0; symbols != NULL && i < n; i++) {
+        if (i > 0)
+            fputs(", ", log_file);
+        watchdog_string(symbols[i]);
+    }
+    fputs("]}\n", log_file);
+    fflush(log_file);
+    free(symbols);
+}
+
+/* Called by the watchdog thread when the main thread is back */
+static void watchdog_stall_end(const gchar *name, gint64 duration)
+{
+    gint i;
+
+    for (i = WATCHDOG_BUCKETS - 1; i > 0 && duration < buckets[i]; i--)
+        ;
+    counts[i]++;
+    stalls++;
+    total_ms += duration;
+    if (duration > max_ms)
+        max_ms = duration;
+
+    fprintf(log_file, "{\"event\": \"stall_end\", \"pid\": %d, \"source\": ",
+            (int) getpid());
+    watchdog_string(name);
+    fprintf(log_file, ", \"duration_ms\": %lld}\n", (long long) duration);
+    fflush(log_file);
+}
+
+static gpointer watchdog_thread(gpointer data)
+{
+    gint64 now, beat, duration = 0;
+    const gchar *name = NULL;
+    gboolean stall, stall_end, stop;
+
+    for (;;) {
+        g_usleep(WATCHDOG_PERIOD * 1000);
+        now = g_get_monotonic_time();
+
+        g_mutex_lock(&lock);
+        stop = stopping;
+        stall = stall_end = FALSE;
+        beat = last_beat;
+        if (stall_since != 0 && beat != stall_since) {
+            stall_end = TRUE;
+            duration = (beat - stall_since) / 1000;
+            name = stall_source;
+            stall_since = 0;
+        } else if (stall_since == 0 && armed &&
+                   now - beat > (gint64) threshold * 1000) {
+            stall = TRUE;
+            stall_since = beat;
+            name = stall_source = (source != NULL) ? source : "main loop";
+        }
+        g_mutex_unlock(&lock);
+
+        if (stop)
+            break;
+        if (stall)
+            watchdog_stall(name);
+        else if (stall_end)
+            watchdog_stall_end(name, duration);
+    }
+    return NULL;
+}
+
+static void watchdog_beat(gboolean arm)
+{
+    g_mutex_lock(&lock);
+    last_beat = g_get_monotonic_time();
+    armed = arm;
+    g_mutex_unlock(&lock);
+}
+
+static gboolean watchdog_heartbeat(gpointer data)
+{
+    watchdog_beat(TRUE);
+    return TRUE;
+}
+
+static void watchdog_exit(void)
+{
+    gint i;
+
+    /* the histogram is only complete once the thread is done */
+    g_mutex_lock(&lock);
+    stopping = TRUE;
+    g_mutex_unlock(&lock);
+    g_thread_join(thread);
+    thread = NULL;
+
+    fprintf(log_file, "{\"event\": \"histogram\", \"pid\": %d, \"count\": %u, "
+                      "\"total_ms\": %lld, \"max_ms\": %lld, \"buckets\": {",
+            (int) getpid(), stalls, (long long) total_ms, (long long) max_ms);
+    for (i = 0; i < WATCHDOG_BUCKETS; i++)
+        fprintf(log_file, "%s\"%d\": %u", i > 0 ? ", " : "", buckets[i], counts[i]);
+    fputs("}}\n", log_file);
+    fflush(log_file);
+}
+
+static gboolean watched_dispatch(gpointer data)
+{
+    watched_source *watched = data;
+    gboolean result;
+
+    watchdog_begin(watched->name);
+    result = watched->function(watched->data);
+    watchdog_end();
+    return result;
+}
+
+#endif
+
+/* Starts the watchdog thread if XDIALOG_WATCHDOG is set (from the main
+ * thread, before any dialog is set up).
+ */
+void watchdog_init(void)
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+    char *name = getenv(WATCHDOG_FILE);
+    char *ms = getenv(WATCHDOG_THRESHOLD_MS);
+    struct sigaction action;
+
+    if (log_file != NULL || name == NULL || *name == '\0')
+        return;
+
+    if (ms != NULL && atoi(ms) > 0)
+        threshold = atoi(ms);
+    if (strcmp(name, "-") == 0)
+        log_file = stderr;
+    else if ((log_file = fopen(name, "a")) == NULL) {
+        fprintf(stderr, XDIALOG": can't open watchdog file %s: %s\n",
+                name, strerror(errno));
+        return;
+    }
+
+#ifdef HAVE_EXECINFO_H
+    /* the first backtrace() call may load libgcc: not in the signal handler */
+    backtrace(frames, WATCHDOG_FRAMES);
+#endif
+    main_thread = pthread_self();
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = watchdog_backtrace;
+    action.sa_flags = SA_RESTART;    /* blocking reads of the boxes go on */
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR2, &action, NULL);
+
+    last_beat = g_get_monotonic_time();
+    thread = g_thread_new("watchdog", watchdog_thread, NULL);
+    atexit(watchdog_exit);
+#endif
+}
+
+/* The main loop of a dialog is about to run (see destroy_event() for the
+ * end of it): stalls are looked for from now on.
+ */
+void watchdog_start(void)
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+    if (log_file == NULL)
+        return;
+    watchdog_beat(TRUE);
+    if (heartbeat == 0)
+        heartbeat = g_timeout_add_full(G_PRIORITY_HIGH, WATCHDOG_HEARTBEAT,
+                                       watchdog_heartbeat, NULL, NULL);
+#endif
+}
+
+void watchdog_stop(void)
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+    if (log_file == NULL)
+        return;
+    if (heartbeat != 0) {
+        g_source_remove(heartbeat);
+        heartbeat = 0;
+    }
+    watchdog_beat(FALSE);
+#endif
+}
+
+/* Names a (not nested) section of the main thread, which is watched even
+ * outside of the main loop, e.g. the loading of a text box.
+ */
+void watchdog_begin(const gchar *name)
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+    if (log_file == NULL)
+        return;
+    g_mutex_lock(&lock);
+    section_armed = armed;
+    armed = TRUE;
+    source = name;
+    last_beat = g_get_monotonic_time();
+    g_mutex_unlock(&lock);
+#endif
+}
+
+void watchdog_end(void)
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+    if (log_file == NULL)
+        return;
+    g_mutex_lock(&lock);
+    armed = section_armed;
+    source = NULL;
+    last_beat = g_get_monotonic_time();
+    g_mutex_unlock(&lock);
+#endif
+}
+
+/* g_timeout_add(), the source being named "name" in the stall reports (see
+ * watched_timeout_add())
+ */
+guint watchdog_timeout_add(guint interval, GSourceFunc function, gpointer data,
+                           const gchar *name)
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+    if (log_file != NULL) {
+        watched_source *watched = g_new(watched_source, 1);
+        watched->function = function;
+        watched->data = data;
+        watched->name = name;
+        return g_timeout_add_full(G_PRIORITY_DEFAULT, interval, watched_dispatch,
+                                  watched, g_free);
+    }
+#endif
+    return g_timeout_add(interval, function, data);
+}